@@ -155,6 +155,7 @@ DEFINE_SAFE_EQUALITY(CounterResult)
 DEFINE_SAFE_EQUALITY(APIEvent)
 DEFINE_SAFE_EQUALITY(Bindpoint)
 DEFINE_SAFE_EQUALITY(BufferDescription)
+DEFINE_SAFE_EQUALITY(CaptureCostData)
 DEFINE_SAFE_EQUALITY(CaptureFileFormat)
 DEFINE_SAFE_EQUALITY(ConstantBlock)
 DEFINE_SAFE_EQUALITY(DebugMessage)
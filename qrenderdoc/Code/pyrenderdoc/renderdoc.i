@@ -284,6 +284,7 @@ TEMPLATE_ARRAY_INSTANTIATE(rdcarray, CounterResult)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, APIEvent)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, Bindpoint)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, BufferDescription)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, CaptureCostData)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, CaptureFileFormat)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ConstantBlock)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, DebugMessage)
@@ -31,6 +31,7 @@
 #include <QMouseEvent>
 #include <QMutexLocker>
 #include <QScrollBar>
+#include <QSet>
 #include <QTimer>
 #include <QtMath>
 #include "Code/QRDUtils.h"
@@ -307,6 +308,12 @@ private:
   FloatVector m_Position, m_Rotation;
 };
 
+// raw buffers bigger than this aren't fetched all at once, instead they're fetched in pages of
+// roughly BufferPageSize bytes as rows are displayed
+static const uint64_t PagedBufferThreshold = 16 * 1024 * 1024;
+static const uint64_t BufferPageSize = 1024 * 1024;
+static const int MaxCachedBufferPages = 64;
+
 struct BufferData
 {
   BufferData()
@@ -328,10 +335,51 @@ struct BufferData
   bytebuf storage;
   QAtomicInteger<uint32_t> refcount;
 
+  // for large raw buffers storage is left empty, and pages of whole rows are fetched from this
+  // range of the buffer as they're displayed.
+  ResourceId pagedId;
+  uint64_t pagedOffset = 0, pagedSize = 0;
+  uint32_t rowsPerPage = 0;
+
+  // the pages that have been fetched, and the order they were last used in so that only a limited
+  // number are kept. Locked since they can be filled from the replay thread and read by exports.
+  QMutex pageLock;
+  QMap<uint32_t, bytebuf> pages;
+  QList<uint32_t> pageLRU;
+  QSet<uint32_t> pendingPages;
+
   const byte *data() const { return storage.begin(); };
   const byte *end() const { return storage.end(); }
   bool hasData() const { return !storage.empty(); }
-  size_t size() const { return storage.size(); }
+  size_t size() const { return isPaged() ? (size_t)pagedSize : storage.size(); }
+  bool isPaged() const { return rowsPerPage > 0; }
+  uint32_t pageCount() const
+  {
+    uint64_t pageBytes = uint64_t(rowsPerPage) * stride;
+    return uint32_t((pagedSize + pageBytes - 1) / pageBytes);
+  }
+
+  // must be called with pageLock held
+  void touchPage(uint32_t page)
+  {
+    if(pageLRU.isEmpty() || pageLRU.back() != page)
+    {
+      pageLRU.removeOne(page);
+      pageLRU.push_back(page);
+    }
+  }
+
+  void addPage(uint32_t page, bytebuf &bytes)
+  {
+    QMutexLocker autolock(&pageLock);
+
+    pendingPages.remove(page);
+    pages[page].swap(bytes);
+    touchPage(page);
+
+    while(pageLRU.count() > MaxCachedBufferPages)
+      pages.remove(pageLRU.takeFirst());
+  }
 };
 
 struct BufferConfiguration
@@ -560,8 +608,8 @@ static int columnGroupRole = Qt::UserRole + 10000;
 class BufferItemModel : public QAbstractItemModel
 {
 public:
-  BufferItemModel(RDTableView *v, bool vertexInput, bool mesh, QObject *parent)
-      : QAbstractItemModel(parent)
+  BufferItemModel(ICaptureContext &c, RDTableView *v, bool vertexInput, bool mesh, QObject *parent)
+      : QAbstractItemModel(parent), ctx(c)
   {
     vertexInputData = vertexInput;
     meshView = mesh;
@@ -719,12 +767,12 @@ public:
         {
           const FormatElement &el = elementForColumn(col);
 
-          if(el.rgb && el.buffer < config.buffers.size())
-          {
-            const byte *data = config.buffers[el.buffer]->data();
-            const byte *end = config.buffers[el.buffer]->end();
+          QByteArray pagedRow;
+          const byte *data = NULL, *end = NULL;
 
-            data += config.buffers[el.buffer]->stride * row;
+          if(el.rgb && el.buffer < config.buffers.size() &&
+             rowData(config.buffers[el.buffer], row, pagedRow, data, end))
+          {
             data += el.offset;
 
             // only slightly wasteful, we need to fetch all variants together
@@ -831,13 +879,13 @@ public:
 
           if(el.buffer < config.buffers.size())
           {
-            const byte *data = config.buffers[el.buffer]->data();
-            const byte *end = config.buffers[el.buffer]->end();
+            QByteArray pagedRow;
+            const byte *data = NULL, *end = NULL;
 
-            if(!el.perinstance)
-              data += config.buffers[el.buffer]->stride * idx;
-            else
-              data += config.buffers[el.buffer]->stride * instIdx;
+            // rows that haven't been fetched yet are filled in once they arrive
+            if(!rowData(config.buffers[el.buffer], el.perinstance ? instIdx : idx, pagedRow, data,
+                        end))
+              return lit("...");
 
             data += el.offset;
 
@@ -966,7 +1014,135 @@ public:
 
   const BufferConfiguration &getConfig() { return config; }
 private:
+  // get the data for a row, from which elements are read up to end. For paged buffers the row is
+  // copied into pagedRow, since the page can be evicted once the lock is released. If the row's
+  // page hasn't been fetched yet it's requested and false is returned, except off the UI thread
+  // where it's fetched immediately.
+  bool rowData(BufferData *buf, uint32_t row, QByteArray &pagedRow, const byte *&data,
+               const byte *&end) const
+  {
+    if(!buf->isPaged())
+    {
+      data = buf->data() + buf->stride * row;
+      end = buf->end();
+      return true;
+    }
+
+    uint32_t page = row / buf->rowsPerPage;
+    uint32_t pageRow = row % buf->rowsPerPage;
+
+    bool loaded = false;
+
+    for(int attempt = 0; attempt < 2 && !loaded; attempt++)
+    {
+      {
+        QMutexLocker autolock(&buf->pageLock);
+
+        auto it = buf->pages.find(page);
+        if(it != buf->pages.end())
+        {
+          buf->touchPage(page);
+
+          const bytebuf &bytes = it.value();
+          size_t offs = buf->stride * pageRow;
+
+          if(offs < bytes.size())
+            pagedRow = QByteArray((const char *)bytes.data() + offs,
+                                  (int)qMin(buf->stride, bytes.size() - offs));
+
+          loaded = true;
+        }
+      }
+
+      if(!loaded)
+      {
+        // exports read every row from a background thread, so fetch there directly rather than
+        // returning placeholders
+        if(GUIInvoke::onUIThread())
+          break;
+
+        fetchPage(buf, page, true);
+      }
+    }
+
+    if(!loaded)
+    {
+      fetchPage(buf, page, false);
+      return false;
+    }
+
+    // prefetch the neighbouring page in whichever direction this row is closer to, so scrolling
+    // doesn't stall at page boundaries
+    if(pageRow >= buf->rowsPerPage / 2)
+      fetchPage(buf, page + 1, false);
+    else if(page > 0)
+      fetchPage(buf, page - 1, false);
+
+    data = (const byte *)pagedRow.constData();
+    end = data + pagedRow.size();
+    return true;
+  }
+
+  void fetchPage(BufferData *buf, uint32_t page, bool synchronous) const
+  {
+    if(page >= buf->pageCount())
+      return;
+
+    {
+      QMutexLocker autolock(&buf->pageLock);
+
+      if(buf->pages.contains(page) || buf->pendingPages.contains(page))
+        return;
+
+      buf->pendingPages.insert(page);
+    }
+
+    const uint64_t pageBytes = uint64_t(buf->rowsPerPage) * buf->stride;
+    const uint64_t offs = buf->pagedOffset + page * pageBytes;
+    const uint64_t len = qMin(pageBytes, buf->pagedSize - page * pageBytes);
+
+    if(synchronous)
+    {
+      bytebuf bytes;
+      ctx.Replay().BlockInvoke([buf, offs, len, &bytes](IReplayController *r) {
+        bytes = r->GetBufferData(buf->pagedId, offs, len);
+      });
+      buf->addPage(page, bytes);
+      return;
+    }
+
+    BufferItemModel *model = (BufferItemModel *)this;
+
+    // keep the data alive until the fetch is done, even if the model moves on to new data
+    buf->ref();
+
+    ctx.Replay().AsyncInvoke([model, buf, page, offs, len](IReplayController *r) {
+      bytebuf bytes = r->GetBufferData(buf->pagedId, offs, len);
+      buf->addPage(page, bytes);
+
+      GUIInvoke::call(model, [model, buf, page]() { model->pageFetched(buf, page); });
+
+      buf->deref();
+    });
+  }
+
+  void pageFetched(BufferData *buf, uint32_t page)
+  {
+    // if we've moved on to other data, buf may have been freed so don't touch it
+    if(!config.buffers.contains(buf) || config.numRows == 0)
+      return;
+
+    uint32_t first = page * buf->rowsPerPage;
+    uint32_t last = qMin(first + buf->rowsPerPage, config.numRows) - 1;
+
+    if(first > last)
+      return;
+
+    emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+  }
+
   // constant data over the item model's lifetime
+  ICaptureContext &ctx;
   // The view that this model is for
   RDTableView *view = NULL;
   // Is this the vertex input stage
@@ -1637,9 +1813,9 @@ BufferViewer::BufferViewer(ICaptureContext &ctx, bool meshview, QWidget *parent)
 {
   ui->setupUi(this);
 
-  m_ModelVSIn = new BufferItemModel(ui->vsinData, true, meshview, this);
-  m_ModelVSOut = new BufferItemModel(ui->vsoutData, false, meshview, this);
-  m_ModelGSOut = new BufferItemModel(ui->gsoutData, false, meshview, this);
+  m_ModelVSIn = new BufferItemModel(m_Ctx, ui->vsinData, true, meshview, this);
+  m_ModelVSOut = new BufferItemModel(m_Ctx, ui->vsoutData, false, meshview, this);
+  m_ModelGSOut = new BufferItemModel(m_Ctx, ui->gsoutData, false, meshview, this);
 
   m_MeshView = meshview;
 
@@ -2203,7 +2379,38 @@ void BufferViewer::OnEventChanged(uint32_t eventId)
         if(len == UINT64_MAX)
           len = 0;
 
-        buf->storage = r->GetBufferData(m_BufferID, m_ByteOffset, len);
+        BufferDescription *desc = m_Ctx.GetBuffer(m_BufferID);
+
+        uint64_t available = 0;
+        if(desc && desc->length > m_ByteOffset)
+          available = desc->length - m_ByteOffset;
+
+        if(len == 0 || len > available)
+          len = available;
+
+        if(len > PagedBufferThreshold)
+        {
+          // too large to fetch up front, only fetch the first page now and let the model fetch
+          // the rest as it's displayed
+          buf->stride = 0;
+          for(const FormatElement &el : bufdata->vsinConfig.columns)
+            buf->stride += el.byteSize();
+
+          buf->stride = qMax((size_t)1, buf->stride);
+
+          buf->pagedId = m_BufferID;
+          buf->pagedOffset = m_ByteOffset;
+          buf->pagedSize = len;
+          buf->rowsPerPage = uint32_t(qMax((uint64_t)1, BufferPageSize / buf->stride));
+
+          bytebuf firstPage = r->GetBufferData(
+              m_BufferID, m_ByteOffset, qMin(len, uint64_t(buf->rowsPerPage) * buf->stride));
+          buf->addPage(0, firstPage);
+        }
+        else
+        {
+          buf->storage = r->GetBufferData(m_BufferID, m_ByteOffset, len);
+        }
       }
       else
       {
@@ -2222,7 +2429,7 @@ void BufferViewer::OnEventChanged(uint32_t eventId)
 
         buf->stride = qMax((size_t)1, buf->stride);
 
-        uint32_t bufCount = uint32_t(buf->size());
+        uint64_t bufCount = buf->size();
 
         bufdata->vsinConfig.numRows = uint32_t((bufCount + buf->stride - 1) / buf->stride);
         bufdata->vsinConfig.unclampedNumRows = 0;
@@ -3421,7 +3628,25 @@ void BufferViewer::exportData(const BufferExport &params)
       {
         // this is the simplest possible case, we just dump the contents of the first buffer, as
         // it's tightly packed
-        f->write((const char *)config.buffers[0]->data(), int(config.buffers[0]->size()));
+        BufferData *buf = config.buffers[0];
+
+        if(buf->isPaged())
+        {
+          // stream large buffers out a page at a time instead of fetching them whole
+          for(uint64_t offs = 0; offs < buf->pagedSize; offs += BufferPageSize)
+          {
+            bytebuf bytes;
+            m_Ctx.Replay().BlockInvoke([buf, offs, &bytes](IReplayController *r) {
+              bytes = r->GetBufferData(buf->pagedId, buf->pagedOffset + offs,
+                                       qMin(BufferPageSize, buf->pagedSize - offs));
+            });
+            f->write((const char *)bytes.data(), int(bytes.size()));
+          }
+        }
+        else
+        {
+          f->write((const char *)buf->data(), int(buf->size()));
+        }
       }
       else
       {
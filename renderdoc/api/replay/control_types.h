@@ -536,6 +536,38 @@ struct NewChildData
 
 DECLARE_REFLECTION_STRUCT(NewChildData);
 
+DOCUMENT(R"(The accumulated capture overhead for one type of API call, as measured by the optional
+capture cost accounting on the target.
+)");
+struct CaptureCostData
+{
+  DOCUMENT("");
+  CaptureCostData() = default;
+  CaptureCostData(const CaptureCostData &) = default;
+
+  bool operator==(const CaptureCostData &o) const
+  {
+    return name == o.name && count == o.count && microseconds == o.microseconds;
+  }
+  bool operator<(const CaptureCostData &o) const
+  {
+    if(!(microseconds == o.microseconds))
+      return microseconds > o.microseconds;
+    if(!(count == o.count))
+      return count < o.count;
+    return name < o.name;
+  }
+
+  DOCUMENT("The name of the API call or chunk.");
+  rdcstr name;
+  DOCUMENT("The number of times this call was recorded.");
+  uint64_t count = 0;
+  DOCUMENT("The total CPU time in microseconds spent on capture work for this call.");
+  double microseconds = 0.0;
+};
+
+DECLARE_REFLECTION_STRUCT(CaptureCostData);
+
 DOCUMENT("A message from a target control connection.");
 struct TargetControlMessage
 {
@@ -563,6 +595,11 @@ or has finished, it will be -1.0
 
   DOCUMENT("The number of the capturable windows");
   uint32_t capturableWindowCount = 0;
+
+  DOCUMENT(R"(The accumulated capture costs per API call, most expensive first, as a list of
+:class:`CaptureCostData`.
+)");
+  rdcarray<CaptureCostData> captureCosts;
 };
 
 DECLARE_REFLECTION_STRUCT(TargetControlMessage);
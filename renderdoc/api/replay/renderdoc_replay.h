@@ -1477,6 +1477,15 @@ The details of the types of messages that can be received are listed under
   DOCUMENT("Cycle the currently active window if there are more windows to capture.");
   virtual void CycleActiveWindow() = 0;
 
+  DOCUMENT(R"(Request the per-call capture costs accumulated on the target. The first request
+enables cost accounting on the target if it wasn't already enabled via the environment.
+
+The costs will arrive later as a :data:`TargetControlMessageType.CaptureCosts` message.
+
+:param bool reset: ``True`` if the accumulated costs should be reset after being returned.
+)");
+  virtual void RequestCaptureCosts(bool reset) = 0;
+
 protected:
   ITargetControl() = default;
   ~ITargetControl() = default;
@@ -3338,6 +3338,14 @@ DOCUMENT(R"(The type of message received from or sent to an application target c
 .. data:: CaptureProgress
 
   Progress update on an on-going frame capture.
+
+.. data:: CapturableWindowCount
+
+  The number of capturable windows has changed.
+
+.. data:: CaptureCosts
+
+  The accumulated per-call capture costs, in response to a request.
 )");
 enum class TargetControlMessageType : uint32_t
 {
@@ -3350,7 +3358,8 @@ enum class TargetControlMessageType : uint32_t
   RegisterAPI,
   NewChild,
   CaptureProgress,
-  CapturableWindowCount
+  CapturableWindowCount,
+  CaptureCosts,
 };
 
 DECLARE_REFLECTION_ENUM(TargetControlMessageType);
@@ -0,0 +1,224 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/threading.h"
+#include <deque>
+#include <thread>
+
+namespace Threading
+{
+uint32_t GetNumHardwareThreads()
+{
+  static uint32_t numThreads = RDCMAX(1U, (uint32_t)std::thread::hardware_concurrency());
+  return numThreads;
+}
+
+void ParallelFor(uint32_t count, std::function<void(uint32_t)> func, uint32_t maxThreads)
+{
+  if(count == 0)
+    return;
+
+  if(maxThreads == 0)
+    maxThreads = GetNumHardwareThreads();
+
+  uint32_t numThreads = RDCMIN(count, maxThreads);
+
+  // nothing to gain from spinning up threads, run inline
+  if(numThreads <= 1)
+  {
+    for(uint32_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  volatile int32_t next = -1;
+
+  auto worker = [&next, &func, count]() {
+    for(;;)
+    {
+      uint32_t idx = (uint32_t)Atomic::Inc32(&next);
+      if(idx >= count)
+        break;
+      func(idx);
+    }
+  };
+
+  std::vector<ThreadHandle> threads;
+  threads.resize(numThreads - 1);
+
+  for(ThreadHandle &t : threads)
+    t = CreateThread(worker);
+
+  // the calling thread participates too rather than idling
+  worker();
+
+  for(ThreadHandle t : threads)
+  {
+    JoinThread(t);
+    CloseThread(t);
+  }
+}
+
+struct Task::Job
+{
+  enum
+  {
+    Queued,
+    Running,
+    Finished,
+  };
+
+  volatile int32_t refcount = 1;
+  volatile int32_t state = Queued;
+  std::function<void()> func;
+
+  void AddRef() { Atomic::Inc32(&refcount); }
+  void Release()
+  {
+    if(Atomic::Dec32(&refcount) == 0)
+      delete this;
+  }
+
+  // runs the job if nobody else has claimed it yet. Returns false if it was already claimed
+  bool TryRun()
+  {
+    if(Atomic::CmpExch32(&state, Queued, Running) != Queued)
+      return false;
+
+    func();
+    func = std::function<void()>();
+
+    Atomic::CmpExch32(&state, Running, Finished);
+    return true;
+  }
+
+  bool IsFinished() { return Atomic::CmpExch32(&state, Finished, Finished) == Finished; }
+};
+
+static struct
+{
+  CriticalSection lock;
+  std::deque<Task::Job *> queue;
+  uint32_t numWorkers = 0;
+} taskPool;
+
+static void TaskWorker()
+{
+  for(;;)
+  {
+    Task::Job *job = NULL;
+
+    {
+      SCOPED_LOCK(taskPool.lock);
+      if(taskPool.queue.empty())
+      {
+        // decided under the lock so RunAsync never queues work after the last worker has left
+        taskPool.numWorkers--;
+        return;
+      }
+
+      job = taskPool.queue.front();
+      taskPool.queue.pop_front();
+    }
+
+    // the job may already have been run by a thread waiting on it
+    job->TryRun();
+    job->Release();
+  }
+}
+
+Task::Task(const Task &o) : m_Job(o.m_Job)
+{
+  if(m_Job)
+    m_Job->AddRef();
+}
+
+Task &Task::operator=(const Task &o)
+{
+  if(o.m_Job)
+    o.m_Job->AddRef();
+  if(m_Job)
+    m_Job->Release();
+  m_Job = o.m_Job;
+  return *this;
+}
+
+Task::~Task()
+{
+  if(m_Job)
+    m_Job->Release();
+}
+
+void Task::Wait() const
+{
+  if(!m_Job || m_Job->TryRun())
+    return;
+
+  while(!m_Job->IsFinished())
+    Sleep(0);
+}
+
+bool Task::IsDone() const
+{
+  return !m_Job || m_Job->IsFinished();
+}
+
+Task MakeDeferred(std::function<void()> func)
+{
+  Task ret;
+  ret.m_Job = new Task::Job;
+  ret.m_Job->func = func;
+  return ret;
+}
+
+Task RunAsync(std::function<void()> func)
+{
+  Task ret;
+  ret.m_Job = new Task::Job;
+  ret.m_Job->func = func;
+
+  bool spawn = false;
+
+  {
+    SCOPED_LOCK(taskPool.lock);
+
+    // the queue holds its own reference, released by whichever worker pops it
+    ret.m_Job->AddRef();
+    taskPool.queue.push_back(ret.m_Job);
+
+    if(taskPool.numWorkers < GetNumHardwareThreads())
+    {
+      taskPool.numWorkers++;
+      spawn = true;
+    }
+  }
+
+  if(spawn)
+  {
+    DetachThread(CreateThread(TaskWorker));
+  }
+
+  return ret;
+}
+};
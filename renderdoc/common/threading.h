@@ -89,6 +89,51 @@ public:
 private:
   SpinLock *m_Spin;
 };
+
+// returns the number of hardware threads available, always at least 1.
+uint32_t GetNumHardwareThreads();
+
+// calls func(i) for every i in [0, count), spread across up to maxThreads threads including the
+// calling thread. If maxThreads is 0 the number of hardware threads is used. Indices are handed
+// out dynamically so uneven work balances itself. Returns once every invocation has completed.
+void ParallelFor(uint32_t count, std::function<void(uint32_t)> func, uint32_t maxThreads = 0);
+
+// handle to a job submitted with RunAsync. Copies refer to the same job. Waiting on a job that no
+// worker has picked up yet runs it on the waiting thread instead, so waits never depend on a free
+// worker and jobs may safely wait on other jobs.
+class Task
+{
+public:
+  Task() = default;
+  Task(const Task &o);
+  Task &operator=(const Task &o);
+  ~Task();
+
+  // blocks until the job has completed. Does nothing for a default-constructed task
+  void Wait() const;
+  bool IsDone() const;
+
+  // internal shared state, only used by the implementation
+  struct Job;
+
+private:
+  Job *m_Job = NULL;
+
+  friend Task RunAsync(std::function<void()> func);
+
+// creates a task that is never queued, and instead runs on whichever thread first waits on it. For
+// work that is often not needed at all.
+Task MakeDeferred(std::function<void()> func);
+  friend Task MakeDeferred(std::function<void()> func);
+};
+
+// queues func to run on a shared pool of background threads, spawned on demand up to the number of
+// hardware threads and exiting when the queue drains. The returned task can be waited on.
+Task RunAsync(std::function<void()> func);
+
+// creates a task that is never queued, and instead runs on whichever thread first waits on it. For
+// work that is often not needed at all.
+Task MakeDeferred(std::function<void()> func);
 };
 
 #define SCOPED_LOCK(cs) Threading::ScopedLock CONCAT(scopedlock, __LINE__)(&cs);
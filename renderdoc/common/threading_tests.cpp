@@ -71,4 +71,77 @@ TEST_CASE("Test spin lock", "[threading]")
   CHECK(finalValue == value);
 }
 
+TEST_CASE("Test async tasks", "[threading]")
+{
+  SECTION("Every task runs exactly once")
+  {
+    volatile int32_t counter = 0;
+    std::vector<int32_t> ran;
+    ran.resize(256);
+
+    std::vector<Threading::Task> tasks;
+    for(int i = 0; i < 256; i++)
+      tasks.push_back(Threading::RunAsync([&counter, &ran, i]() {
+        Atomic::Inc32(&counter);
+        ran[i]++;
+      }));
+
+    for(const Threading::Task &t : tasks)
+      t.Wait();
+
+    CHECK(counter == 256);
+    for(int i = 0; i < 256; i++)
+      CHECK(ran[i] == 1);
+
+    for(const Threading::Task &t : tasks)
+      CHECK(t.IsDone());
+  };
+
+  SECTION("Tasks can wait on other tasks")
+  {
+    int first = 0, second = 0;
+
+    Threading::Task a = Threading::RunAsync([&first]() {
+      Threading::Sleep(5);
+      first = 5;
+    });
+
+    Threading::Task b = Threading::RunAsync([a, &first, &second]() {
+      a.Wait();
+      second = first * 2;
+    });
+
+    // copies share the same job
+    Threading::Task c = b;
+    c.Wait();
+
+    CHECK(b.IsDone());
+    CHECK(first == 5);
+    CHECK(second == 10);
+  };
+
+  SECTION("Deferred tasks only run when waited on")
+  {
+    int ran = 0;
+
+    Threading::Task t = Threading::MakeDeferred([&ran]() { ran++; });
+
+    Threading::Sleep(5);
+    CHECK(ran == 0);
+    CHECK_FALSE(t.IsDone());
+
+    t.Wait();
+    t.Wait();
+    CHECK(ran == 1);
+    CHECK(t.IsDone());
+  };
+
+  SECTION("Default tasks are complete")
+  {
+    Threading::Task t;
+    t.Wait();
+    CHECK(t.IsDone());
+  };
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
@@ -0,0 +1,242 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "capture_cost.h"
+#include <algorithm>
+#include "api/replay/control_types.h"
+#include "common/common.h"
+#include "common/threading.h"
+#include "strings/string_utils.h"
+
+namespace CaptureCost
+{
+volatile int32_t enabled = 0;
+
+// chunk types are small sequential enums per API, so a fixed table indexed directly by type keeps
+// Record() down to two adds. Anything beyond lands in the last slot.
+static const uint32_t MaxChunkTypes = 4096;
+
+// chunk types are only unique within one chunk name lookup (e.g. GL and vulkan both start at the
+// same value), so each thread has a table per lookup. A thread only ever writes a handful of
+// different kinds of chunk.
+static const uint32_t MaxLookups = 8;
+
+struct TypeTable
+{
+  uint64_t count[MaxChunkTypes] = {};
+  uint64_t ticks[MaxChunkTypes] = {};
+};
+
+struct ThreadTables
+{
+  ChunkNameLookup lookup[MaxLookups] = {};
+  TypeTable *types[MaxLookups] = {};
+};
+
+static Threading::CriticalSection tableLock;
+static std::vector<rdcpair<ChunkNameLookup, TypeTable *>> tables;
+static uint64_t tableSlot = 0;
+
+// calibration of Now() against Timing::GetTick(), taken when accounting is enabled
+static uint64_t calibrationStart = 0;
+static uint64_t calibrationTickStart = 0;
+
+static TypeTable *GetThreadTable(ChunkNameLookup lookup)
+{
+  ThreadTables *thread = (ThreadTables *)Threading::GetTLSValue(tableSlot);
+
+  if(thread == NULL)
+  {
+    thread = new ThreadTables;
+    Threading::SetTLSValue(tableSlot, thread);
+  }
+
+  for(uint32_t i = 0; i < MaxLookups; i++)
+  {
+    if(thread->lookup[i] == lookup)
+      return thread->types[i];
+
+    if(thread->lookup[i] == NULL)
+    {
+      thread->lookup[i] = lookup;
+      thread->types[i] = new TypeTable;
+
+      SCOPED_LOCK(tableLock);
+      tables.push_back({lookup, thread->types[i]});
+
+      return thread->types[i];
+    }
+  }
+
+  return NULL;
+}
+
+void SetEnabled(bool enable)
+{
+  SCOPED_LOCK(tableLock);
+
+  if(enable && !IsEnabled())
+  {
+    // the slot must exist before anyone can see the enabled flag and call Record()
+    if(tableSlot == 0)
+      tableSlot = Threading::AllocateTLSSlot();
+
+    calibrationStart = Now();
+    calibrationTickStart = Timing::GetTick();
+
+    RDCLOG("Enabling capture cost accounting");
+  }
+
+  enabled = enable ? 1 : 0;
+}
+
+void Reset()
+{
+  SCOPED_LOCK(tableLock);
+
+  // other threads may still be adding, a lost increment here only affects diagnostic totals
+  for(const rdcpair<ChunkNameLookup, TypeTable *> &table : tables)
+  {
+    memset(table.second->count, 0, sizeof(table.second->count));
+    memset(table.second->ticks, 0, sizeof(table.second->ticks));
+  }
+}
+
+void Record(uint32_t chunkType, ChunkNameLookup lookup, uint64_t ticks)
+{
+  // serialisers without a lookup are internal (e.g. target control packets), not capture chunks
+  if(lookup == NULL)
+    return;
+
+  TypeTable *table = GetThreadTable(lookup);
+
+  if(table == NULL)
+    return;
+
+  uint32_t idx = RDCMIN(chunkType, MaxChunkTypes - 1);
+
+  table->count[idx]++;
+  table->ticks[idx] += ticks;
+}
+
+rdcarray<CaptureCostData> Gather()
+{
+  rdcarray<CaptureCostData> ret;
+
+  SCOPED_LOCK(tableLock);
+
+  if(tables.empty())
+    return ret;
+
+  // microseconds per Now() tick
+  double tickScale = 1000.0 / Timing::GetTickFrequency();
+  double scale = tickScale;
+
+  uint64_t elapsed = Now() - calibrationStart;
+  uint64_t elapsedTicks = Timing::GetTick() - calibrationTickStart;
+
+  if(elapsed > 0 && elapsed != elapsedTicks)
+    scale = tickScale * double(elapsedTicks) / double(elapsed);
+
+  std::vector<ChunkNameLookup> lookups;
+  for(const rdcpair<ChunkNameLookup, TypeTable *> &table : tables)
+    if(std::find(lookups.begin(), lookups.end(), table.first) == lookups.end())
+      lookups.push_back(table.first);
+
+  for(ChunkNameLookup lookup : lookups)
+  {
+    for(uint32_t i = 0; i < MaxChunkTypes; i++)
+    {
+      uint64_t count = 0, ticks = 0;
+
+      for(const rdcpair<ChunkNameLookup, TypeTable *> &table : tables)
+      {
+        if(table.first != lookup)
+          continue;
+
+        count += table.second->count[i];
+        ticks += table.second->ticks[i];
+      }
+
+      if(count == 0)
+        continue;
+
+      CaptureCostData cost;
+      cost.name = i == MaxChunkTypes - 1 ? "Other" : lookup(i);
+      cost.count = count;
+      cost.microseconds = double(ticks) * scale;
+
+      ret.push_back(cost);
+    }
+  }
+
+  std::sort(ret.begin(), ret.end());
+
+  return ret;
+}
+};
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+static std::string FirstLookup(uint32_t chunkType)
+{
+  return StringFormat::Fmt("First %u", chunkType);
+}
+
+static std::string SecondLookup(uint32_t chunkType)
+{
+  return StringFormat::Fmt("Second %u", chunkType);
+}
+
+TEST_CASE("Capture costs are kept separate per chunk lookup", "[capturecost]")
+{
+  CaptureCost::SetEnabled(true);
+  CaptureCost::Reset();
+
+  CaptureCost::Record(5, &FirstLookup, 100);
+  CaptureCost::Record(5, &FirstLookup, 100);
+  CaptureCost::Record(5, &SecondLookup, 100);
+
+  // no lookup means a serialiser that isn't writing capture chunks
+  CaptureCost::Record(5, NULL, 100);
+
+  rdcarray<CaptureCostData> costs = CaptureCost::Gather();
+
+  CaptureCost::Reset();
+  CaptureCost::SetEnabled(false);
+
+  REQUIRE(costs.size() == 2);
+
+  std::sort(costs.begin(), costs.end(),
+            [](const CaptureCostData &a, const CaptureCostData &b) { return a.name < b.name; });
+
+  CHECK(costs[0].name == "First 5");
+  CHECK(costs[0].count == 2);
+  CHECK(costs[1].name == "Second 5");
+  CHECK(costs[1].count == 1);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "api/replay/basic_types.h"
+#include "os/os_specific.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CAPTURE_COST_RDTSC() __rdtsc()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CAPTURE_COST_RDTSC() __rdtsc()
+#endif
+
+struct CaptureCostData;
+
+// Optional low-overhead accounting of where capture time goes, aggregated per chunk type. When
+// enabled each serialised chunk adds its count and the CPU time spent recording it into a table
+// owned by the recording thread, so the hot path is lock-free. Tables are summed on demand for the
+// overlay or a target control request.
+namespace CaptureCost
+{
+typedef std::string (*ChunkNameLookup)(uint32_t chunkType);
+
+extern volatile int32_t enabled;
+
+inline bool IsEnabled()
+{
+  return enabled != 0;
+}
+
+// raw timestamp from the cheapest counter available, only meaningful as a difference
+inline uint64_t Now()
+{
+#if defined(CAPTURE_COST_RDTSC)
+  return CAPTURE_COST_RDTSC();
+#else
+  return Timing::GetTick();
+#endif
+}
+
+void SetEnabled(bool enable);
+void Reset();
+
+// accumulate one chunk's cost on the calling thread. Types are counted separately per lookup, and
+// chunks without a lookup aren't counted.
+void Record(uint32_t chunkType, ChunkNameLookup lookup, uint64_t ticks);
+
+// returns the accumulated costs for every chunk type seen, most expensive first
+rdcarray<CaptureCostData> Gather();
+};
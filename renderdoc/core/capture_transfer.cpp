@@ -0,0 +1,490 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "capture_transfer.h"
+#include "3rdparty/zstd/xxhash.h"
+#include "common/common.h"
+#include "lz4/lz4.h"
+#include "os/os_specific.h"
+
+namespace CaptureTransfer
+{
+// files are sent in blocks of this size, which is also the granularity transfers resume at
+static const uint32_t BlockSize = 1024 * 1024;
+
+// blocks are only sent compressed if that saves at least 1/MinSavingDivisor of their size. Most of
+// a capture is already compressed, and those blocks are sent as-is.
+static const uint32_t MinSavingDivisor = 20;
+
+static rdcstr PartialPath(const rdcstr &localpath)
+{
+  return localpath + ".partial";
+}
+
+static uint64_t HashBlock(const byte *data, uint32_t size)
+{
+  return XXH64(data, size, 0);
+}
+
+ResumePoint GetResumePoint(const rdcstr &localpath)
+{
+  ResumePoint ret;
+
+  FILE *f = FileIO::fopen(PartialPath(localpath).c_str(), "rb");
+
+  if(!f)
+    return ret;
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t size = FileIO::ftell64(f);
+
+  // only whole blocks are kept, anything after the last one will be sent again
+  uint64_t offset = size - (size % BlockSize);
+
+  if(offset > 0)
+  {
+    bytebuf block;
+    block.resize(BlockSize);
+
+    FileIO::fseek64(f, offset - BlockSize, SEEK_SET);
+
+    if(FileIO::fread(block.data(), 1, BlockSize, f) == BlockSize)
+    {
+      ret.offset = offset;
+      ret.blockHash = HashBlock(block.data(), BlockSize);
+    }
+  }
+
+  FileIO::fclose(f);
+
+  return ret;
+}
+
+bool Send(StreamWriter &writer, const rdcstr &filename, const ResumePoint &resume,
+          RENDERDOC_ProgressCallback progress)
+{
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  uint64_t totalSize = 0;
+
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    totalSize = FileIO::ftell64(f);
+  }
+  else
+  {
+    RDCERR("Couldn't open '%s' to send", filename.c_str());
+  }
+
+  bytebuf block, packed;
+  block.resize(BlockSize);
+  packed.resize(LZ4_COMPRESSBOUND(BlockSize));
+
+  // only skip what the receiver has if its last block still matches our file, otherwise start over
+  uint64_t offset = 0;
+
+  if(f && resume.offset > 0 && resume.offset <= totalSize && (resume.offset % BlockSize) == 0)
+  {
+    FileIO::fseek64(f, resume.offset - BlockSize, SEEK_SET);
+
+    if(FileIO::fread(block.data(), 1, BlockSize, f) == BlockSize &&
+       HashBlock(block.data(), BlockSize) == resume.blockHash)
+      offset = resume.offset;
+    else
+      RDCLOG("Partial copy of '%s' doesn't match, sending from the start", filename.c_str());
+  }
+
+  if(f)
+    FileIO::fseek64(f, offset, SEEK_SET);
+
+  writer.Write(totalSize);
+  writer.Write(offset);
+
+  if(progress)
+    progress(0.0001f);
+
+  bool success = (f != NULL) && !writer.IsErrored();
+
+  while(success && offset < totalSize)
+  {
+    uint32_t rawSize = (uint32_t)RDCMIN((uint64_t)BlockSize, totalSize - offset);
+
+    if(FileIO::fread(block.data(), 1, rawSize, f) != rawSize)
+    {
+      RDCERR("Error reading '%s' at offset %llu", filename.c_str(), offset);
+      success = false;
+      break;
+    }
+
+    uint64_t hash = HashBlock(block.data(), rawSize);
+
+    int packedSize = LZ4_compress_default((const char *)block.data(), (char *)packed.data(),
+                                          (int)rawSize, (int)packed.size());
+
+    // a stored size equal to the raw size means the block is uncompressed
+    uint32_t storedSize = rawSize;
+    const byte *data = block.data();
+
+    if(packedSize > 0 && (uint32_t)packedSize < rawSize - rawSize / MinSavingDivisor)
+    {
+      storedSize = (uint32_t)packedSize;
+      data = packed.data();
+    }
+
+    writer.Write(rawSize);
+    writer.Write(storedSize);
+    writer.Write(hash);
+    writer.Write(data, storedSize);
+
+    if(writer.IsErrored())
+    {
+      success = false;
+      break;
+    }
+
+    offset += rawSize;
+
+    if(progress)
+      progress(float(offset) / float(totalSize));
+  }
+
+  if(f)
+    FileIO::fclose(f);
+
+  if(progress)
+    progress(1.0f);
+
+  return success;
+}
+
+bool Receive(StreamReader &reader, const rdcstr &localpath, RENDERDOC_ProgressCallback progress)
+{
+  uint64_t totalSize = 0, offset = 0;
+
+  reader.Read(totalSize);
+  reader.Read(offset);
+
+  if(reader.IsErrored())
+    return false;
+
+  rdcstr partialPath = PartialPath(localpath);
+
+  FILE *f = NULL;
+
+  if(offset > 0)
+  {
+    // the sender is resuming, so append after the whole blocks we already have
+    f = FileIO::fopen(partialPath.c_str(), "r+b");
+
+    if(f)
+    {
+      FileIO::fseek64(f, 0, SEEK_END);
+
+      if(FileIO::ftell64(f) < offset)
+      {
+        FileIO::fclose(f);
+        f = NULL;
+      }
+      else
+      {
+        FileIO::ftruncateat(f, offset);
+        FileIO::fseek64(f, offset, SEEK_SET);
+      }
+    }
+
+    if(!f)
+      RDCERR("Partial copy at '%s' is missing, can't resume", partialPath.c_str());
+  }
+  else
+  {
+    FileIO::CreateParentDirectory(localpath.c_str());
+
+    f = FileIO::fopen(partialPath.c_str(), "wb");
+
+    if(!f)
+      RDCERR("Couldn't open '%s' to receive into", partialPath.c_str());
+  }
+
+  if(!f)
+    return false;
+
+  bytebuf block, packed;
+  block.resize(BlockSize);
+  packed.resize(LZ4_COMPRESSBOUND(BlockSize));
+
+  if(progress)
+    progress(0.0001f);
+
+  bool success = true;
+
+  while(offset < totalSize)
+  {
+    uint32_t rawSize = 0, storedSize = 0;
+    uint64_t hash = 0;
+
+    reader.Read(rawSize);
+    reader.Read(storedSize);
+    reader.Read(hash);
+
+    if(reader.IsErrored())
+    {
+      success = false;
+      break;
+    }
+
+    if(rawSize == 0 || rawSize > BlockSize || storedSize > rawSize ||
+       rawSize > totalSize - offset)
+    {
+      RDCERR("Invalid block header at offset %llu: %u bytes stored as %u", offset, rawSize,
+             storedSize);
+      success = false;
+      break;
+    }
+
+    if(storedSize == rawSize)
+    {
+      reader.Read(block.data(), rawSize);
+    }
+    else
+    {
+      reader.Read(packed.data(), storedSize);
+
+      if(!reader.IsErrored() &&
+         LZ4_decompress_safe((const char *)packed.data(), (char *)block.data(), (int)storedSize,
+                             (int)BlockSize) != (int)rawSize)
+      {
+        RDCERR("Failed to decompress block at offset %llu", offset);
+        success = false;
+        break;
+      }
+    }
+
+    if(reader.IsErrored())
+    {
+      success = false;
+      break;
+    }
+
+    if(HashBlock(block.data(), rawSize) != hash)
+    {
+      RDCERR("Block at offset %llu failed hash check", offset);
+      success = false;
+      break;
+    }
+
+    if(FileIO::fwrite(block.data(), 1, rawSize, f) != rawSize)
+    {
+      RDCERR("Error writing to '%s'", partialPath.c_str());
+      success = false;
+      break;
+    }
+
+    offset += rawSize;
+
+    if(progress)
+      progress(float(offset) / float(totalSize));
+  }
+
+  FileIO::fclose(f);
+
+  if(success && !FileIO::Move(partialPath.c_str(), localpath.c_str(), true))
+  {
+    RDCERR("Couldn't move completed copy to '%s'", localpath.c_str());
+    success = false;
+  }
+
+  if(progress)
+    progress(1.0f);
+
+  return success;
+}
+};
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+// alternate blocks of easily compressible data and noise, so both block encodings get used
+static std::vector<byte> MakeTransferData(uint32_t numBlocks, uint32_t tail, uint32_t seed)
+{
+  std::vector<byte> ret;
+  ret.resize(numBlocks * CaptureTransfer::BlockSize + tail);
+
+  uint32_t state = seed;
+
+  for(size_t i = 0; i < ret.size(); i++)
+  {
+    if((i / CaptureTransfer::BlockSize) % 2 == 0)
+    {
+      ret[i] = byte(i / 64 + seed);
+    }
+    else
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      ret[i] = byte(state);
+    }
+  }
+
+  return ret;
+}
+
+TEST_CASE("Test capture transfer resumes after a dropped connection", "[network]")
+{
+  std::string tempFolder = FileIO::GetTempFolderFilename();
+
+  rdcstr source = tempFolder + "/renderdoc_transfer_src.rdc";
+  rdcstr dest = tempFolder + "/renderdoc_transfer_dst.rdc";
+
+  FileIO::Delete(dest.c_str());
+  FileIO::Delete((dest + ".partial").c_str());
+
+  const uint32_t numBlocks = 6;
+
+  std::vector<byte> data = MakeTransferData(numBlocks, 12345, 0x1234567);
+
+  REQUIRE(FileIO::dump(source.c_str(), data.data(), data.size()));
+
+  SECTION("Transfer in memory")
+  {
+    StreamWriter writer(StreamWriter::DefaultScratchSize);
+
+    CHECK(CaptureTransfer::GetResumePoint(dest).offset == 0);
+    CHECK(CaptureTransfer::Send(writer, source, CaptureTransfer::GetResumePoint(dest)));
+
+    // the compressible half of the file should be much smaller on the wire
+    CHECK(writer.GetOffset() < data.size() * 3 / 4);
+
+    StreamReader reader(writer.GetData(), writer.GetOffset());
+
+    CHECK(CaptureTransfer::Receive(reader, dest, RENDERDOC_ProgressCallback()));
+
+    std::vector<byte> received;
+    CHECK(FileIO::slurp(dest.c_str(), received));
+    CHECK((received == data));
+    CHECK_FALSE(FileIO::exists((dest + ".partial").c_str()));
+  }
+
+  SECTION("Resume over a dropped connection")
+  {
+    uint16_t port = 8245;
+    Network::Socket *server = NULL;
+
+    for(uint16_t probe = 0; probe < 20; probe++)
+    {
+      server = Network::CreateServerSocket("localhost", port, 2);
+
+      if(server)
+        break;
+
+      port++;
+    }
+
+    REQUIRE(server);
+
+    // transfer over a fresh connection, with the sender optionally dropping it part-way through
+    auto transfer = [server, port, &source, &dest](const CaptureTransfer::ResumePoint &resume,
+                                                   float dropAt, bool &sent, bool &received) {
+      Network::Socket *sender = Network::CreateClientSocket("localhost", port, 10);
+      REQUIRE(sender);
+      Network::Socket *receiver = server->AcceptClient(250);
+      REQUIRE(receiver);
+
+      {
+        StreamWriter writer(sender, Ownership::Nothing);
+        StreamReader reader(receiver, Ownership::Nothing);
+
+        Threading::ThreadHandle recvThread = Threading::CreateThread([&reader, &dest, &received]() {
+          received = CaptureTransfer::Receive(reader, dest, RENDERDOC_ProgressCallback());
+        });
+
+        sent = CaptureTransfer::Send(writer, source, resume, [sender, dropAt, &writer](float p) {
+          writer.Flush();
+          if(p >= dropAt && p < 1.0f)
+            sender->Shutdown();
+        });
+        writer.Flush();
+
+        Threading::JoinThread(recvThread);
+        Threading::CloseThread(recvThread);
+      }
+
+      SAFE_DELETE(sender);
+      SAFE_DELETE(receiver);
+    };
+
+    bool sent = true, received = true;
+
+    // drop the connection once half the blocks have been sent
+    transfer(CaptureTransfer::ResumePoint(), 0.5f, sent, received);
+
+    CHECK_FALSE(sent);
+    CHECK_FALSE(received);
+    CHECK_FALSE(FileIO::exists(dest.c_str()));
+
+    CaptureTransfer::ResumePoint resume = CaptureTransfer::GetResumePoint(dest);
+
+    CHECK(resume.offset >= CaptureTransfer::BlockSize);
+    CHECK(resume.offset < data.size());
+
+    SECTION("Resuming completes the file")
+    {
+      transfer(resume, 2.0f, sent, received);
+
+      CHECK(sent);
+      CHECK(received);
+
+      std::vector<byte> result;
+      CHECK(FileIO::slurp(dest.c_str(), result));
+      CHECK((result == data));
+      CHECK_FALSE(FileIO::exists((dest + ".partial").c_str()));
+    }
+
+    SECTION("A changed source is sent again from the start")
+    {
+      data = MakeTransferData(numBlocks, 12345, 0x7654321);
+
+      REQUIRE(FileIO::dump(source.c_str(), data.data(), data.size()));
+
+      transfer(resume, 2.0f, sent, received);
+
+      CHECK(sent);
+      CHECK(received);
+
+      std::vector<byte> result;
+      CHECK(FileIO::slurp(dest.c_str(), result));
+      CHECK((result == data));
+    }
+
+    SAFE_DELETE(server);
+  }
+
+  FileIO::Delete(source.c_str());
+  FileIO::Delete(dest.c_str());
+  FileIO::Delete((dest + ".partial").c_str());
+}
+
+#endif
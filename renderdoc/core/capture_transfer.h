@@ -0,0 +1,55 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "api/replay/basic_types.h"
+#include "serialise/streamio.h"
+
+// Copies capture files over a network stream in checksummed blocks, each LZ4-compressed when that
+// actually saves space. The receiver writes into a partial file next to the destination, so if the
+// connection drops a later transfer to the same destination carries on from the last complete
+// block instead of starting again.
+namespace CaptureTransfer
+{
+struct ResumePoint
+{
+  // how many bytes of the file the receiver already has
+  uint64_t offset = 0;
+  // hash of the last block the receiver has, so the sender can check the file hasn't changed
+  uint64_t blockHash = 0;
+};
+
+// returns where a transfer to localpath can resume from, ignoring any incomplete trailing block
+ResumePoint GetResumePoint(const rdcstr &localpath);
+
+// sends filename, starting from the resume point if it still matches the file's contents
+bool Send(StreamWriter &writer, const rdcstr &filename, const ResumePoint &resume,
+          RENDERDOC_ProgressCallback progress = RENDERDOC_ProgressCallback());
+
+// receives a file sent with Send() into localpath. On failure the data received so far is kept so
+// that the transfer can be resumed
+bool Receive(StreamReader &reader, const rdcstr &localpath, RENDERDOC_ProgressCallback progress);
+};
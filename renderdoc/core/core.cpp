@@ -28,6 +28,7 @@
 #include <algorithm>
 #include "api/replay/version.h"
 #include "common/common.h"
+#include "core/replay_trace.h"
 #include "hooks/hooks.h"
 #include "maths/formatpacking.h"
 #include "replay/replay_driver.h"
@@ -330,6 +331,17 @@ void RenderDoc::Initialise()
     {
       RDCWARN("Couldn't open socket for target control");
     }
+
+    // cost accounting can otherwise be enabled later by a target control request
+    const char *costEnv = Process::GetEnvVariable("RENDERDOC_CAPTURE_COST");
+    if(costEnv && costEnv[0] && costEnv[0] != '0')
+      CaptureCost::SetEnabled(true);
+  }
+  else
+  {
+    const char *traceEnv = Process::GetEnvVariable("RENDERDOC_REPLAY_TRACE");
+    if(traceEnv && traceEnv[0])
+      ReplayTrace::Start(traceEnv);
   }
 
   // set default capture log - useful for when hooks aren't setup
@@ -842,6 +854,15 @@ std::string RenderDoc::GetOverlayText(RDCDriver driver, uint32_t frameNumber, in
     overlayText += StringFormat::Fmt("%llu chunks - %.2f MB\n", Chunk::NumLiveChunks(),
                                      float(Chunk::TotalMem()) / 1024.0f / 1024.0f);
 #endif
+
+    if(CaptureCost::IsEnabled())
+    {
+      rdcarray<CaptureCostData> costs = CaptureCost::Gather();
+
+      for(size_t i = 0; i < costs.size() && i < 5; i++)
+        overlayText += StringFormat::Fmt("%s: %llu calls, %.2f ms\n", costs[i].name.c_str(),
+                                         costs[i].count, costs[i].microseconds / 1000.0);
+    }
   }
   else if(capturesEnabled)
   {
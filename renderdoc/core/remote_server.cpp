@@ -29,7 +29,9 @@
 #include "android/android.h"
 #include "api/replay/renderdoc_replay.h"
 #include "api/replay/version.h"
+#include "core/capture_transfer.h"
 #include "core/core.h"
+#include "core/replay_trace.h"
 #include "os/os_specific.h"
 #include "replay/replay_controller.h"
 #include "serialise/rdcfile.h"
@@ -78,13 +80,114 @@ enum RemoteServerPacket
 RDCCOMPILE_ASSERT((int)eRemoteServer_RemoteServerCount < (int)eReplayProxy_First,
                   "Remote server and Replay Proxy packets overlap");
 
+DECLARE_REFLECTION_ENUM(RemoteServerPacket);
+
+template <>
+rdcstr DoStringise(const RemoteServerPacket &el)
+{
+  BEGIN_ENUM_STRINGISE(RemoteServerPacket);
+  {
+    STRINGISE_ENUM_NAMED(eRemoteServer_Noop, "Noop");
+    STRINGISE_ENUM_NAMED(eRemoteServer_Handshake, "Handshake");
+    STRINGISE_ENUM_NAMED(eRemoteServer_VersionMismatch, "VersionMismatch");
+    STRINGISE_ENUM_NAMED(eRemoteServer_Busy, "Busy");
+    STRINGISE_ENUM_NAMED(eRemoteServer_Ping, "Ping");
+    STRINGISE_ENUM_NAMED(eRemoteServer_RemoteDriverList, "RemoteDriverList");
+    STRINGISE_ENUM_NAMED(eRemoteServer_TakeOwnershipCapture, "TakeOwnershipCapture");
+    STRINGISE_ENUM_NAMED(eRemoteServer_CopyCaptureToRemote, "CopyCaptureToRemote");
+    STRINGISE_ENUM_NAMED(eRemoteServer_CopyCaptureFromRemote, "CopyCaptureFromRemote");
+    STRINGISE_ENUM_NAMED(eRemoteServer_OpenLog, "OpenLog");
+    STRINGISE_ENUM_NAMED(eRemoteServer_LogOpenProgress, "LogOpenProgress");
+    STRINGISE_ENUM_NAMED(eRemoteServer_LogOpened, "LogOpened");
+    STRINGISE_ENUM_NAMED(eRemoteServer_HasCallstacks, "HasCallstacks");
+    STRINGISE_ENUM_NAMED(eRemoteServer_InitResolver, "InitResolver");
+    STRINGISE_ENUM_NAMED(eRemoteServer_ResolverProgress, "ResolverProgress");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetResolve, "GetResolve");
+    STRINGISE_ENUM_NAMED(eRemoteServer_CloseLog, "CloseLog");
+    STRINGISE_ENUM_NAMED(eRemoteServer_HomeDir, "HomeDir");
+    STRINGISE_ENUM_NAMED(eRemoteServer_ListDir, "ListDir");
+    STRINGISE_ENUM_NAMED(eRemoteServer_ExecuteAndInject, "ExecuteAndInject");
+    STRINGISE_ENUM_NAMED(eRemoteServer_ShutdownServer, "ShutdownServer");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetDriverName, "GetDriverName");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetSectionCount, "GetSectionCount");
+    STRINGISE_ENUM_NAMED(eRemoteServer_FindSectionByName, "FindSectionByName");
+    STRINGISE_ENUM_NAMED(eRemoteServer_FindSectionByType, "FindSectionByType");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetSectionProperties, "GetSectionProperties");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetSectionContents, "GetSectionContents");
+    STRINGISE_ENUM_NAMED(eRemoteServer_WriteSection, "WriteSection");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetAvailableGPUs, "GetAvailableGPUs");
+  }
+  END_ENUM_STRINGISE();
+}
+
 #define WRITE_DATA_SCOPE() WriteSerialiser &ser = writer;
 #define READ_DATA_SCOPE() ReadSerialiser &ser = reader;
 
+// limits on how many clients the server handles at once, configured in remoteserver.conf. The
+// defaults serve a single client and tell any others that the server is busy.
+struct RemoteServerLimits
+{
+  // the number of clients that can be connected at once
+  uint32_t maxClients = 1;
+  // the number of those clients that can have a capture open at once. The rest wait their turn
+  uint32_t maxReplays = 1;
+  // the largest capture a client can open, in uncompressed bytes. 0 means there is no limit
+  uint64_t replayMemory = 0;
+};
+
+// hands out a fixed number of replay slots between connected clients, so that a shared server never
+// has more captures open than it has been configured for. Clients beyond that wait for a slot.
+class ReplayScheduler
+{
+public:
+  ReplayScheduler(uint32_t maxReplays) : m_Free(RDCMAX(1U, maxReplays)) {}
+  // waits until a slot is free and takes it. While waiting, waitTick is called periodically and
+  // can return false to give up without taking a slot.
+  bool Acquire(std::function<bool()> waitTick)
+  {
+    for(;;)
+    {
+      {
+        SCOPED_LOCK(m_Lock);
+        if(m_Free > 0)
+        {
+          m_Free--;
+          return true;
+        }
+      }
+
+      if(waitTick && !waitTick())
+        return false;
+
+      Threading::Sleep(10);
+    }
+  }
+
+  void Release()
+  {
+    SCOPED_LOCK(m_Lock);
+    m_Free++;
+  }
+
+  // drivers report load progress through a process-wide callback, so captures are loaded one at a
+  // time even when several are open at once.
+  Threading::CriticalSection &LoadLock() { return m_LoadLock; }
+private:
+  Threading::CriticalSection m_Lock;
+  Threading::CriticalSection m_LoadLock;
+  uint32_t m_Free;
+};
+
 struct ClientThread
 {
   ClientThread()
-      : socket(NULL), allowExecution(false), killThread(false), killServer(false), thread(0)
+      : socket(NULL),
+        allowExecution(false),
+        killThread(false),
+        killServer(false),
+        thread(0),
+        limits(NULL),
+        scheduler(NULL)
   {
   }
 
@@ -95,8 +198,21 @@ struct ClientThread
   bool killServer;
 
   Threading::ThreadHandle thread;
+
+  const RemoteServerLimits *limits;
+  ReplayScheduler *scheduler;
 };
 
+// replaying needs roughly as much memory as the capture's uncompressed contents, so that is what
+// the per-client memory limit is checked against.
+static uint64_t EstimateReplayMemory(const RDCFile *rdc)
+{
+  uint64_t ret = 0;
+  for(int i = 0; i < rdc->NumSections(); i++)
+    ret += rdc->GetSectionProperties(i).uncompressedSize;
+  return ret;
+}
+
 static void InactiveRemoteClientThread(ClientThread *threadData)
 {
   uint32_t ip = threadData->socket->GetRemoteIP();
@@ -208,6 +324,7 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
   ReplayProxy *proxy = NULL;
   RDCFile *rdc = NULL;
   Callstack::StackResolver *resolver = NULL;
+  bool replaySlot = false;
 
   WriteSerialiser writer(new StreamWriter(client, Ownership::Nothing), Ownership::Stream);
   ReadSerialiser reader(new StreamReader(client, Ownership::Nothing), Ownership::Stream);
@@ -232,6 +349,12 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     if(client == NULL)
       continue;
 
+    // proxied replay packets are traced by the proxy itself
+    rdcstr packetName;
+    if(ReplayTrace::IsEnabled() && (int)type < eReplayProxy_First)
+      packetName = "RemoteServer::" + ToStr(type);
+    ReplayTrace::Scope packetScope(packetName.empty() ? NULL : packetName.c_str());
+
     if(type == eRemoteServer_Ping)
     {
       reader.EndChunk();
@@ -299,10 +422,13 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     else if(type == eRemoteServer_CopyCaptureFromRemote)
     {
       std::string path;
+      CaptureTransfer::ResumePoint resume;
 
       {
         READ_DATA_SCOPE();
         SERIALISE_ELEMENT(path);
+        SERIALISE_ELEMENT(resume.offset);
+        SERIALISE_ELEMENT(resume.blockHash);
       }
 
       reader.EndChunk();
@@ -311,8 +437,7 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
         WRITE_DATA_SCOPE();
         SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureFromRemote);
 
-        StreamReader fileStream(FileIO::fopen(path.c_str(), "rb"));
-        ser.SerialiseStream(path, fileStream);
+        CaptureTransfer::Send(*ser.GetWriter(), path, resume);
       }
     }
     else if(type == eRemoteServer_CopyCaptureToRemote)
@@ -325,19 +450,20 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       FileIO::CreateParentDirectory(path);
 
+      bool success = false;
+
       {
         READ_DATA_SCOPE();
 
-        StreamWriter streamWriter(FileIO::fopen(path.c_str(), "wb"), Ownership::Stream);
-
-        ser.SerialiseStream(path.c_str(), streamWriter, NULL);
+        success = CaptureTransfer::Receive(*ser.GetReader(), path, NULL);
       }
 
       reader.EndChunk();
 
-      if(reader.IsErrored())
+      if(!success || reader.IsErrored())
       {
         FileIO::Delete(path.c_str());
+        FileIO::Delete((path + ".partial").c_str());
 
         RDCERR("Network error receiving file");
         break;
@@ -428,6 +554,14 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
           default: break;
         }
       }
+      else if(threadData->limits->replayMemory > 0 &&
+              EstimateReplayMemory(rdc) > threadData->limits->replayMemory)
+      {
+        RDCERR("'%s' needs %llu bytes to replay, over the limit of %llu", path.c_str(),
+               EstimateReplayMemory(rdc), threadData->limits->replayMemory);
+
+        status = ReplayStatus::NetworkRemoteBusy;
+      }
       else
       {
         if(RenderDoc::Inst().HasRemoteDriver(rdc->GetDriver()))
@@ -435,8 +569,6 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
           bool kill = false;
           float progress = 0.0f;
 
-          RenderDoc::Inst().SetProgressCallback<LoadProgress>([&progress](float p) { progress = p; });
-
           Threading::ThreadHandle ticker = Threading::CreateThread([&writer, &kill, &progress]() {
             while(!kill)
             {
@@ -449,36 +581,53 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
             }
           });
 
-          // if we have a replay driver, try to create it so we can display a local preview e.g.
-          if(RenderDoc::Inst().HasReplayDriver(rdc->GetDriver()))
-          {
-            status = RenderDoc::Inst().CreateReplayDriver(rdc, opts, &replayDriver);
-            if(replayDriver)
-              remoteDriver = replayDriver;
-          }
-          else
-          {
-            status = RenderDoc::Inst().CreateRemoteDriver(rdc, opts, &remoteDriver);
-          }
+          // wait for a replay slot. The ticker keeps the client informed meanwhile, and if it can't
+          // reach the client any more there's no point waiting.
+          replaySlot = threadData->scheduler->Acquire(
+              [threadData, &writer]() { return !threadData->killThread && !writer.IsErrored(); });
 
-          if(status != ReplayStatus::Succeeded || remoteDriver == NULL)
+          if(!replaySlot)
           {
-            RDCERR("Failed to create remote driver for driver '%s'", rdc->GetDriverName().c_str());
+            status = ReplayStatus::NetworkIOFailed;
           }
           else
           {
-            status = remoteDriver->ReadLogInitialisation(rdc, false);
+            SCOPED_LOCK(threadData->scheduler->LoadLock());
+
+            RenderDoc::Inst().SetProgressCallback<LoadProgress>(
+                [&progress](float p) { progress = p; });
 
-            if(status != ReplayStatus::Succeeded)
+            // if we have a replay driver, try to create it so we can display a local preview e.g.
+            if(RenderDoc::Inst().HasReplayDriver(rdc->GetDriver()))
             {
-              RDCERR("Failed to initialise remote driver.");
+              status = RenderDoc::Inst().CreateReplayDriver(rdc, opts, &replayDriver);
+              if(replayDriver)
+                remoteDriver = replayDriver;
+            }
+            else
+            {
+              status = RenderDoc::Inst().CreateRemoteDriver(rdc, opts, &remoteDriver);
+            }
 
-              remoteDriver->Shutdown();
-              remoteDriver = NULL;
+            if(status != ReplayStatus::Succeeded || remoteDriver == NULL)
+            {
+              RDCERR("Failed to create remote driver for driver '%s'", rdc->GetDriverName().c_str());
             }
-          }
+            else
+            {
+              status = remoteDriver->ReadLogInitialisation(rdc, false);
+
+              if(status != ReplayStatus::Succeeded)
+              {
+                RDCERR("Failed to initialise remote driver.");
 
-          RenderDoc::Inst().SetProgressCallback<LoadProgress>(RENDERDOC_ProgressCallback());
+                remoteDriver->Shutdown();
+                remoteDriver = NULL;
+              }
+            }
+
+            RenderDoc::Inst().SetProgressCallback<LoadProgress>(RENDERDOC_ProgressCallback());
+          }
 
           kill = true;
           Threading::JoinThread(ticker);
@@ -488,6 +637,11 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
           {
             proxy = new ReplayProxy(reader, writer, remoteDriver, replayDriver, previewWindow);
           }
+          else if(replaySlot)
+          {
+            threadData->scheduler->Release();
+            replaySlot = false;
+          }
         }
         else
         {
@@ -762,6 +916,10 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       SAFE_DELETE(rdc);
       SAFE_DELETE(resolver);
+
+      if(replaySlot)
+        threadData->scheduler->Release();
+      replaySlot = false;
     }
     else if(type == eRemoteServer_ExecuteAndInject)
     {
@@ -818,6 +976,9 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
   SAFE_DELETE(rdc);
   SAFE_DELETE(resolver);
 
+  if(replaySlot)
+    threadData->scheduler->Release();
+
   for(size_t i = 0; i < tempFiles.size(); i++)
   {
     FileIO::Delete(tempFiles[i].c_str());
@@ -831,6 +992,12 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
   SAFE_DELETE(client);
 }
 
+static void RunRemoteServer(Network::Socket *sock,
+                            const std::vector<rdcpair<uint32_t, uint32_t> > &listenRanges,
+                            bool allowExecution, const RemoteServerLimits &limits,
+                            RENDERDOC_KillCallback killReplay,
+                            RENDERDOC_PreviewWindowCallback previewWindow);
+
 void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
                                    RENDERDOC_KillCallback killReplay,
                                    RENDERDOC_PreviewWindowCallback previewWindow)
@@ -842,6 +1009,7 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
 
   std::vector<rdcpair<uint32_t, uint32_t> > listenRanges;
   bool allowExecution = true;
+  RemoteServerLimits limits;
 
   FILE *f = FileIO::fopen(FileIO::GetAppFolderFilename("remoteserver.conf").c_str(), "r");
 
@@ -881,6 +1049,25 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
 
       continue;
     }
+    else if(line.substr(0, sizeof("maxclients") - 1) == "maxclients")
+    {
+      limits.maxClients = RDCMAX(1U, (uint32_t)atoi(line.c_str() + sizeof("maxclients")));
+
+      continue;
+    }
+    else if(line.substr(0, sizeof("maxreplays") - 1) == "maxreplays")
+    {
+      limits.maxReplays = RDCMAX(1U, (uint32_t)atoi(line.c_str() + sizeof("maxreplays")));
+
+      continue;
+    }
+    else if(line.substr(0, sizeof("replaymemory") - 1) == "replaymemory")
+    {
+      // specified in megabytes
+      limits.replayMemory = uint64_t(atoll(line.c_str() + sizeof("replaymemory"))) << 20;
+
+      continue;
+    }
 
     RDCLOG("Malformed line '%s'. See documentation for file format.", line.c_str());
   }
@@ -918,9 +1105,25 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   else
     RDCLOG("Blocking execution commands");
 
+  RDCLOG("Serving up to %u clients, %u replaying at once", limits.maxClients, limits.maxReplays);
+
+  if(limits.replayMemory > 0)
+    RDCLOG("Refusing captures needing more than %llu MB to replay", limits.replayMemory >> 20);
+
+  RunRemoteServer(sock, listenRanges, allowExecution, limits, killReplay, previewWindow);
+}
+
+static void RunRemoteServer(Network::Socket *sock,
+                            const std::vector<rdcpair<uint32_t, uint32_t> > &listenRanges,
+                            bool allowExecution, const RemoteServerLimits &limits,
+                            RENDERDOC_KillCallback killReplay,
+                            RENDERDOC_PreviewWindowCallback previewWindow)
+{
   RDCLOG("Replay host ready for requests...");
 
-  ClientThread *activeClientData = NULL;
+  ReplayScheduler scheduler(limits.maxReplays);
+
+  std::vector<ClientThread *> actives;
 
   std::vector<ClientThread *> inactives;
 
@@ -928,7 +1131,11 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   {
     Network::Socket *client = sock->AcceptClient(0);
 
-    if(activeClientData && activeClientData->killServer)
+    bool killServer = false;
+    for(ClientThread *active : actives)
+      killServer |= active->killServer;
+
+    if(killServer)
       break;
 
     // reap any dead inactive threads
@@ -944,14 +1151,19 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
       }
     }
 
-    // reap our active connection possibly
-    if(activeClientData && activeClientData->socket == NULL)
+    // reap any active connections that have closed
+    for(size_t i = 0; i < actives.size();)
     {
-      Threading::JoinThread(activeClientData->thread);
-      Threading::CloseThread(activeClientData->thread);
+      if(actives[i]->socket == NULL)
+      {
+        Threading::JoinThread(actives[i]->thread);
+        Threading::CloseThread(actives[i]->thread);
+        delete actives[i];
+        actives.erase(actives.begin() + i);
+        continue;
+      }
 
-      delete activeClientData;
-      activeClientData = NULL;
+      i++;
     }
 
     if(client == NULL)
@@ -995,17 +1207,20 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
       continue;
     }
 
-    if(activeClientData == NULL)
+    if(actives.size() < limits.maxClients)
     {
-      activeClientData = new ClientThread();
-      activeClientData->socket = client;
-      activeClientData->allowExecution = allowExecution;
+      ClientThread *active = new ClientThread();
+      active->socket = client;
+      active->allowExecution = allowExecution;
+      active->limits = &limits;
+      active->scheduler = &scheduler;
 
-      activeClientData->thread = Threading::CreateThread([activeClientData, previewWindow]() {
-        ActiveRemoteClientThread(activeClientData, previewWindow);
-      });
+      active->thread = Threading::CreateThread(
+          [active, previewWindow]() { ActiveRemoteClientThread(active, previewWindow); });
 
-      RDCLOG("Making active connection");
+      actives.push_back(active);
+
+      RDCLOG("Making active connection (%zu of %u)", actives.size(), limits.maxClients);
     }
     else
     {
@@ -1022,14 +1237,14 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
     }
   }
 
-  if(activeClientData && activeClientData->socket != NULL)
-  {
-    activeClientData->killThread = true;
+  for(ClientThread *active : actives)
+    active->killThread = true;
 
-    Threading::JoinThread(activeClientData->thread);
-    Threading::CloseThread(activeClientData->thread);
-
-    delete activeClientData;
+  for(ClientThread *active : actives)
+  {
+    Threading::JoinThread(active->thread);
+    Threading::CloseThread(active->thread);
+    delete active;
   }
 
   // shut down client threads
@@ -1043,37 +1258,9 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   SAFE_DELETE(sock);
 }
 
-extern "C" RENDERDOC_API ReplayStatus RENDERDOC_CC
-RENDERDOC_CreateRemoteServerConnection(const char *URL, IRemoteServer **rend)
+// exchanges versions with a server that's just been connected to. On failure the socket is closed.
+static ReplayStatus RemoteServerHandshake(Network::Socket *&sock)
 {
-  if(rend == NULL)
-    return ReplayStatus::InternalError;
-
-  rdcstr host = "localhost";
-  if(URL != NULL && URL[0] != '\0')
-    host = URL;
-
-  rdcstr deviceID = host;
-
-  IDeviceProtocolHandler *protocol = RenderDoc::Inst().GetDeviceProtocol(deviceID);
-
-  uint16_t port = RenderDoc_RemoteServerPort;
-
-  if(protocol)
-  {
-    deviceID = protocol->GetDeviceID(deviceID);
-    host = protocol->RemapHostname(deviceID);
-    if(host.empty())
-      return ReplayStatus::NetworkIOFailed;
-
-    port = protocol->RemapPort(deviceID, port);
-  }
-
-  Network::Socket *sock = Network::CreateClientSocket(host.c_str(), port, 750);
-
-  if(sock == NULL)
-    return ReplayStatus::NetworkIOFailed;
-
   uint32_t version = RemoteServerProtocolVersion;
 
   {
@@ -1115,6 +1302,45 @@ RENDERDOC_CreateRemoteServerConnection(const char *URL, IRemoteServer **rend)
     }
   }
 
+  return ReplayStatus::Succeeded;
+}
+
+extern "C" RENDERDOC_API ReplayStatus RENDERDOC_CC
+RENDERDOC_CreateRemoteServerConnection(const char *URL, IRemoteServer **rend)
+{
+  if(rend == NULL)
+    return ReplayStatus::InternalError;
+
+  rdcstr host = "localhost";
+  if(URL != NULL && URL[0] != '\0')
+    host = URL;
+
+  rdcstr deviceID = host;
+
+  IDeviceProtocolHandler *protocol = RenderDoc::Inst().GetDeviceProtocol(deviceID);
+
+  uint16_t port = RenderDoc_RemoteServerPort;
+
+  if(protocol)
+  {
+    deviceID = protocol->GetDeviceID(deviceID);
+    host = protocol->RemapHostname(deviceID);
+    if(host.empty())
+      return ReplayStatus::NetworkIOFailed;
+
+    port = protocol->RemapPort(deviceID, port);
+  }
+
+  Network::Socket *sock = Network::CreateClientSocket(host.c_str(), port, 750);
+
+  if(sock == NULL)
+    return ReplayStatus::NetworkIOFailed;
+
+  ReplayStatus status = RemoteServerHandshake(sock);
+
+  if(status != ReplayStatus::Succeeded)
+    return status;
+
   if(protocol)
     *rend = protocol->CreateRemoteServer(sock, deviceID);
   else
@@ -1362,10 +1588,15 @@ void RemoteServer::CopyCaptureFromRemote(const char *remotepath, const char *loc
 {
   std::string path = remotepath;
 
+  // pick up from any earlier copy to the same path that was interrupted
+  CaptureTransfer::ResumePoint resume = CaptureTransfer::GetResumePoint(localpath);
+
   {
     WRITE_DATA_SCOPE();
     SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureFromRemote);
     SERIALISE_ELEMENT(path);
+    SERIALISE_ELEMENT(resume.offset);
+    SERIALISE_ELEMENT(resume.blockHash);
   }
 
   {
@@ -1374,11 +1605,7 @@ void RemoteServer::CopyCaptureFromRemote(const char *remotepath, const char *loc
 
     if(type == eRemoteServer_CopyCaptureFromRemote)
     {
-      StreamWriter streamWriter(FileIO::fopen(localpath, "wb"), Ownership::Stream);
-
-      ser.SerialiseStream(localpath, streamWriter, progress);
-
-      if(ser.IsErrored())
+      if(!CaptureTransfer::Receive(*ser.GetReader(), localpath, progress) || ser.IsErrored())
       {
         RDCERR("Network error receiving file");
         return;
@@ -1399,8 +1626,8 @@ rdcstr RemoteServer::CopyCaptureToRemote(const char *filename, RENDERDOC_Progres
     WRITE_DATA_SCOPE();
     SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureToRemote);
 
-    StreamReader fileStream(FileIO::fopen(filename, "rb"));
-    ser.SerialiseStream(filename, fileStream, progress);
+    // the server receives into a new temporary file each time, so there's nothing to resume
+    CaptureTransfer::Send(*ser.GetWriter(), filename, CaptureTransfer::ResumePoint(), progress);
   }
 
   std::string path;
@@ -1918,3 +2145,193 @@ rdcarray<rdcstr> RemoteServer::GetResolve(const rdcarray<uint64_t> &callstack)
 
   return StackFrames;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Test remote server replay scheduler", "[remoteserver]")
+{
+  ReplayScheduler scheduler(2);
+
+  CHECK(scheduler.Acquire(NULL));
+  CHECK(scheduler.Acquire(NULL));
+
+  SECTION("Waiting clients can give up")
+  {
+    int ticks = 0;
+    CHECK_FALSE(scheduler.Acquire([&ticks]() { return ++ticks < 5; }));
+    CHECK(ticks == 5);
+  }
+
+  SECTION("Waiting clients get the next free slot")
+  {
+    int32_t acquired = 0;
+
+    Threading::ThreadHandle waiter = Threading::CreateThread([&scheduler, &acquired]() {
+      if(scheduler.Acquire([]() { return true; }))
+        Atomic::Inc32(&acquired);
+    });
+
+    Threading::Sleep(50);
+    CHECK(Atomic::CmpExch32(&acquired, 0, 0) == 0);
+
+    scheduler.Release();
+
+    Threading::JoinThread(waiter);
+    Threading::CloseThread(waiter);
+
+    CHECK(acquired == 1);
+
+    // the released slot went to the waiter, so there's still none free
+    int ticks = 0;
+    CHECK_FALSE(scheduler.Acquire([&ticks]() { return ++ticks < 2; }));
+  }
+}
+
+TEST_CASE("Test remote server with several clients connected", "[network][remoteserver]")
+{
+  std::string tempFolder = FileIO::GetTempFolderFilename();
+
+  // captures for a driver nothing can replay, one over the memory limit and one under it
+  rdcstr small = tempFolder + "/renderdoc_remote_small.rdc";
+  rdcstr large = tempFolder + "/renderdoc_remote_large.rdc";
+
+  {
+    std::vector<byte> contents(1024 * 1024);
+
+    for(const rdcstr &path : {small, large})
+    {
+      RDCFile rdc;
+      rdc.SetData(RDCDriver::Custom9, "Unreplayable", 0, NULL);
+      rdc.Create(path.c_str());
+
+      SectionProperties props;
+      props.type = SectionType::FrameCapture;
+      props.name = ToStr(props.type);
+      props.version = 1;
+
+      StreamWriter *w = rdc.WriteSection(props);
+      w->Write(contents.data(), path == large ? contents.size() : 64);
+      w->Finish();
+      delete w;
+    }
+  }
+
+  uint16_t port = 38950;
+  Network::Socket *server = NULL;
+
+  for(uint16_t probe = 0; probe < 20; probe++)
+  {
+    server = Network::CreateServerSocket("localhost", port, 4);
+
+    if(server)
+      break;
+
+    port++;
+  }
+
+  REQUIRE(server);
+
+  RemoteServerLimits limits;
+  limits.maxClients = 3;
+  limits.maxReplays = 1;
+  limits.replayMemory = 512 * 1024;
+
+  Threading::ThreadHandle serverThread = Threading::CreateThread([server, &limits]() {
+    RunRemoteServer(server, {}, false, limits, []() { return false; },
+                    [](bool, const rdcarray<WindowingSystem> &) {
+                      WindowingData ret = {WindowingSystem::Unknown};
+                      return ret;
+                    });
+  });
+
+  auto connect = [port](RemoteServer *&remote) {
+    remote = NULL;
+    Network::Socket *sock = Network::CreateClientSocket("localhost", port, 250);
+    if(sock == NULL)
+      return ReplayStatus::NetworkIOFailed;
+    ReplayStatus status = RemoteServerHandshake(sock);
+    if(status == ReplayStatus::Succeeded)
+      remote = new RemoteServer(sock, "localhost");
+    return status;
+  };
+
+  RemoteServer *clients[3] = {};
+
+  for(RemoteServer *&client : clients)
+    CHECK(connect(client) == ReplayStatus::Succeeded);
+
+  REQUIRE(clients[0]);
+  REQUIRE(clients[1]);
+  REQUIRE(clients[2]);
+
+  // the server is full, so the next client is turned away
+  {
+    RemoteServer *extra = NULL;
+    CHECK(connect(extra) == ReplayStatus::NetworkRemoteBusy);
+    CHECK(extra == NULL);
+  }
+
+  // every session is served at once
+  {
+    int32_t pings = 0;
+
+    std::vector<Threading::ThreadHandle> threads;
+    for(RemoteServer *client : clients)
+    {
+      threads.push_back(Threading::CreateThread([client, &pings]() {
+        for(int i = 0; i < 20; i++)
+        {
+          if(client->Ping() && !client->GetHomeFolder().empty())
+            Atomic::Inc32(&pings);
+        }
+      }));
+    }
+
+    for(Threading::ThreadHandle t : threads)
+    {
+      Threading::JoinThread(t);
+      Threading::CloseThread(t);
+    }
+
+    CHECK(pings == 60);
+  }
+
+  ReplayOptions opts;
+
+  // too large for the per-session limit
+  CHECK(clients[0]->OpenCapture(~0U, large.c_str(), opts, NULL).first ==
+        ReplayStatus::NetworkRemoteBusy);
+
+  // within the limit, but nothing on the server can replay it
+  CHECK(clients[0]->OpenCapture(~0U, small.c_str(), opts, NULL).first ==
+        ReplayStatus::APIUnsupported);
+  CHECK(clients[1]->OpenCapture(~0U, small.c_str(), opts, NULL).first ==
+        ReplayStatus::APIUnsupported);
+
+  // once a client leaves, its place is available again
+  clients[2]->ShutdownConnection();
+  clients[2] = NULL;
+
+  for(int attempt = 0; attempt < 50 && clients[2] == NULL; attempt++)
+  {
+    if(connect(clients[2]) != ReplayStatus::Succeeded)
+      Threading::Sleep(20);
+  }
+
+  REQUIRE(clients[2]);
+  CHECK(clients[2]->Ping());
+
+  clients[1]->ShutdownConnection();
+  clients[2]->ShutdownConnection();
+  clients[0]->ShutdownServerAndConnection();
+
+  Threading::JoinThread(serverThread);
+  Threading::CloseThread(serverThread);
+
+  FileIO::Delete(small.c_str());
+  FileIO::Delete(large.c_str());
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -25,6 +25,7 @@
 
 #include "replay_proxy.h"
 #include "3rdparty/lz4/lz4.h"
+#include "core/replay_trace.h"
 #include "serialise/lz4io.h"
 
 template <>
@@ -180,6 +181,7 @@ struct RemoteExecution
 // the remote server or not.
 #define PROXY_FUNCTION(name, ...)                                     \
   PROXY_DEBUG("Proxying out %s", #name);                              \
+  REPLAY_TRACE_SCOPE("ReplayProxy::" #name);                          \
   if(m_RemoteServer)                                                  \
     return CONCAT(Proxied_, name)(m_Reader, m_Writer, ##__VA_ARGS__); \
   else                                                                \
@@ -0,0 +1,253 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "replay_trace.h"
+#include "common/common.h"
+#include "common/threading.h"
+#include "core/core.h"
+#include "strings/string_utils.h"
+
+namespace ReplayTrace
+{
+volatile int32_t enabled = 0;
+
+static const uint32_t RingSize = 4096;
+
+struct Event
+{
+  char name[64];
+  uint64_t start;
+  uint64_t end;
+};
+
+// single producer (the owning thread) single consumer (the writer) ring. head is only advanced by
+// the producer once an event is complete, tail only by the consumer once an event is written out.
+// Both count up indefinitely and wrap, which unsigned arithmetic handles as RingSize divides 2^32.
+struct ThreadRing
+{
+  uint64_t threadID = 0;
+  volatile uint32_t head = 0;
+  volatile uint32_t tail = 0;
+  int32_t dropped = 0;
+  Event events[RingSize];
+};
+
+static Threading::CriticalSection ringLock;
+static std::vector<ThreadRing *> rings;
+static uint64_t ringSlot = 0;
+
+// held while draining rings into the file, by either the writer thread or Stop()
+static Threading::CriticalSection fileLock;
+static FILE *traceFile = NULL;
+static bool firstEvent = true;
+static uint64_t traceStart = 0;
+static double tickToMicro = 0.0;
+static uint32_t pid = 0;
+
+static Threading::ThreadHandle writerThread = 0;
+static volatile int32_t writerShutdown = 0;
+
+static uint32_t AtomicRead(volatile uint32_t *val)
+{
+  return (uint32_t)Atomic::CmpExch32((volatile int32_t *)val, 0, 0);
+}
+
+static ThreadRing *GetThreadRing()
+{
+  ThreadRing *ring = (ThreadRing *)Threading::GetTLSValue(ringSlot);
+
+  if(ring == NULL)
+  {
+    ring = new ThreadRing;
+    ring->threadID = Threading::GetCurrentID();
+    Threading::SetTLSValue(ringSlot, ring);
+
+    SCOPED_LOCK(ringLock);
+    rings.push_back(ring);
+  }
+
+  return ring;
+}
+
+void Record(const char *name, uint64_t startTick, uint64_t endTick)
+{
+  ThreadRing *ring = GetThreadRing();
+
+  uint32_t head = ring->head;
+
+  // if the writer has fallen a whole ring behind, drop rather than block the replay
+  if(head - AtomicRead(&ring->tail) >= RingSize)
+  {
+    ring->dropped++;
+    return;
+  }
+
+  Event &ev = ring->events[head % RingSize];
+
+  size_t len = RDCMIN(strlen(name), sizeof(ev.name) - 1);
+  memcpy(ev.name, name, len);
+  ev.name[len] = 0;
+  ev.start = startTick;
+  ev.end = endTick;
+
+  // publish the event
+  Atomic::Inc32((volatile int32_t *)&ring->head);
+}
+
+static void WriteString(const std::string &str)
+{
+  FileIO::fwrite(str.data(), 1, str.size(), traceFile);
+}
+
+static void WriteEvent(uint64_t threadID, const Event &ev)
+{
+  // scope names are identifiers or packet names, but escape anything that would break the JSON
+  char name[sizeof(ev.name) * 2];
+  char *out = name;
+  for(const char *c = ev.name; *c; c++)
+  {
+    if(*c == '"' || *c == '\\')
+      *(out++) = '\\';
+    *(out++) = *c < 0x20 ? ' ' : *c;
+  }
+  *out = 0;
+
+  WriteString(StringFormat::Fmt(
+      "%s\n{\"name\":\"%s\",\"cat\":\"replay\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+      "\"pid\":%u,\"tid\":%llu}",
+      firstEvent ? "" : ",", name, double(ev.start - traceStart) * tickToMicro,
+      double(ev.end - ev.start) * tickToMicro, pid, threadID));
+
+  firstEvent = false;
+}
+
+static void Flush()
+{
+  SCOPED_LOCK(fileLock);
+
+  if(!traceFile)
+    return;
+
+  std::vector<ThreadRing *> curRings;
+  {
+    SCOPED_LOCK(ringLock);
+    curRings = rings;
+  }
+
+  for(ThreadRing *ring : curRings)
+  {
+    uint32_t head = AtomicRead(&ring->head);
+    uint32_t tail = ring->tail;
+
+    for(; tail != head; tail++)
+      WriteEvent(ring->threadID, ring->events[tail % RingSize]);
+
+    // release the slots back to the producer
+    Atomic::CmpExch32((volatile int32_t *)&ring->tail, (int32_t)ring->tail, (int32_t)tail);
+  }
+
+  FileIO::fflush(traceFile);
+}
+
+static void ShutdownTrace()
+{
+  Stop();
+}
+
+void Start(const char *filename)
+{
+  SCOPED_LOCK(fileLock);
+
+  if(traceFile)
+    return;
+
+  traceFile = FileIO::fopen(filename, "w");
+
+  if(!traceFile)
+  {
+    RDCERR("Couldn't open replay trace file %s", filename);
+    return;
+  }
+
+  RDCLOG("Writing replay trace to %s", filename);
+
+  // the JSON array format doesn't require the closing ], so a trace is still usable if the process
+  // exits without calling Stop()
+  WriteString("[");
+  firstEvent = true;
+
+  traceStart = Timing::GetTick();
+  tickToMicro = 1000.0 / Timing::GetTickFrequency();
+  pid = Process::GetCurrentPID();
+
+  if(ringSlot == 0)
+    ringSlot = Threading::AllocateTLSSlot();
+
+  writerShutdown = 0;
+  writerThread = Threading::CreateThread([]() {
+    while(Atomic::CmpExch32(&writerShutdown, 0, 0) == 0)
+    {
+      Threading::Sleep(20);
+      Flush();
+    }
+  });
+
+  RenderDoc::Inst().RegisterShutdownFunction(&ShutdownTrace);
+
+  enabled = 1;
+}
+
+void Stop()
+{
+  if(!IsEnabled())
+    return;
+
+  enabled = 0;
+
+  Atomic::Inc32(&writerShutdown);
+
+  // drain anything left over ourselves rather than joining the writer, as this can be called during
+  // module unload where joining isn't safe
+  Flush();
+
+  SCOPED_LOCK(fileLock);
+
+  int32_t dropped = 0;
+  {
+    SCOPED_LOCK(ringLock);
+    for(ThreadRing *ring : rings)
+      dropped += ring->dropped;
+  }
+
+  if(dropped > 0)
+    RDCWARN("Replay trace dropped %d events while the writer was behind", dropped);
+
+  WriteString("\n]\n");
+  FileIO::fclose(traceFile);
+  traceFile = NULL;
+
+  Threading::DetachThread(writerThread);
+  writerThread = 0;
+}
+};
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "os/os_specific.h"
+
+// Optional tracing of where replay time goes, written out as Chrome trace JSON that can be loaded
+// in chrome://tracing or similar viewers. Scopes are pushed into a per-thread ring buffer without
+// locking and a background thread streams them out to the file as it goes, so long sessions don't
+// accumulate events in memory. Enabled by setting RENDERDOC_REPLAY_TRACE to the output filename.
+namespace ReplayTrace
+{
+extern volatile int32_t enabled;
+
+inline bool IsEnabled()
+{
+  return enabled != 0;
+}
+
+void Start(const char *filename);
+void Stop();
+
+// names longer than the fixed event storage are truncated
+void Record(const char *name, uint64_t startTick, uint64_t endTick);
+
+// a NULL name records nothing, for scopes that are only conditionally interesting
+struct Scope
+{
+  Scope(const char *name) : m_Name(name), m_Start(IsEnabled() && name ? Timing::GetTick() : 0) {}
+  ~Scope()
+  {
+    if(m_Start)
+      Record(m_Name, m_Start, Timing::GetTick());
+  }
+
+private:
+  const char *m_Name;
+  uint64_t m_Start;
+};
+};
+
+#define REPLAY_TRACE_SCOPE(name) ReplayTrace::Scope CONCAT(replaytrace, __LINE__)(name);
@@ -53,6 +53,88 @@ void SetReplayResourceIDs()
 
 INSTANTIATE_SERIALISE_TYPE(ResourceManagerInternal::WrittenRecord);
 
+void ReferencedChunkList::ProcessSorted(std::function<void(Chunk *)> callback)
+{
+  typedef rdcpair<int32_t, Chunk *> ChunkEntry;
+
+  if(chunks.empty())
+    return;
+
+  auto idLess = [](const ChunkEntry &a, const ChunkEntry &b) { return a.first < b.first; };
+
+  // split the list into roughly equal segments along run boundaries, so no record's run is split
+  // and each segment can be sorted independently.
+  const size_t minSegmentSize = 64 * 1024;
+  size_t numSegments = RDCMIN((size_t)Threading::GetNumHardwareThreads(),
+                              (chunks.size() + minSegmentSize - 1) / minSegmentSize);
+  numSegments = RDCMAX((size_t)1, numSegments);
+
+  std::vector<size_t> segmentStarts;
+  segmentStarts.reserve(numSegments + 1);
+  segmentStarts.push_back(0);
+
+  {
+    const size_t target = chunks.size() / numSegments;
+    size_t nextSplit = target;
+
+    for(size_t r = 1; r < runStarts.size() && segmentStarts.size() < numSegments; r++)
+    {
+      if(runStarts[r] >= nextSplit)
+      {
+        segmentStarts.push_back(runStarts[r]);
+        nextSplit = runStarts[r] + target;
+      }
+    }
+  }
+
+  segmentStarts.push_back(chunks.size());
+  numSegments = segmentStarts.size() - 1;
+
+  // stable sort preserves insertion order between duplicate IDs within a segment. Most segments
+  // are made of already-sorted runs so check that first before sorting.
+  Threading::ParallelFor((uint32_t)numSegments, [&](uint32_t seg) {
+    auto begin = chunks.begin() + segmentStarts[seg];
+    auto end = chunks.begin() + segmentStarts[seg + 1];
+    if(!std::is_sorted(begin, end, idLess))
+      std::stable_sort(begin, end, idLess);
+  });
+
+  // merge the segments. There are only as many segments as hardware threads so a linear scan over
+  // the heads is cheap. Ties go to the earlier segment so that the last duplicate seen is the one
+  // most recently added, which is the one we keep.
+  std::vector<size_t> heads(segmentStarts.begin(), segmentStarts.end() - 1);
+
+  const ChunkEntry *pending = NULL;
+
+  for(;;)
+  {
+    size_t best = numSegments;
+
+    for(size_t seg = 0; seg < numSegments; seg++)
+    {
+      if(heads[seg] == segmentStarts[seg + 1])
+        continue;
+
+      if(best == numSegments || chunks[heads[seg]].first < chunks[heads[best]].first)
+        best = seg;
+    }
+
+    if(best == numSegments)
+      break;
+
+    const ChunkEntry *cur = &chunks[heads[best]];
+    heads[best]++;
+
+    if(pending && pending->first != cur->first)
+      callback(pending->second);
+
+    pending = cur;
+  }
+
+  if(pending)
+    callback(pending->second);
+}
+
 template <>
 rdcstr DoStringise(const FrameRefType &el)
 {
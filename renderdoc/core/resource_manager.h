@@ -272,6 +272,47 @@ void SetReplayResourceIDs();
 
 struct ResourceRecord;
 
+// A flat list of chunks gathered from resource records to be written into a capture. Each record
+// appends its chunks as one run, which is almost always already sorted by chunk ID since IDs are
+// allocated incrementally as chunks are recorded. This avoids building a std::map node per chunk
+// and lets the final ordering be done as a parallel sort of independent segments followed by a
+// streaming k-way merge.
+struct ReferencedChunkList
+{
+  void AddRun(const std::vector<rdcpair<int32_t, Chunk *>> &run)
+  {
+    if(run.empty())
+      return;
+    runStarts.push_back(chunks.size());
+    chunks.insert(chunks.end(), run.begin(), run.end());
+  }
+
+  size_t size() const { return chunks.size(); }
+  bool empty() const { return chunks.empty(); }
+  // calls callback once for each chunk in ascending ID order. If the same ID was added more than
+  // once the last one added is used, matching the previous std::map assignment behaviour. The
+  // callback is invoked as the merge progresses so writing can begin before it completes.
+  void ProcessSorted(std::function<void(Chunk *)> callback);
+
+  std::vector<rdcpair<int32_t, Chunk *>> chunks;
+  std::vector<size_t> runStarts;
+};
+
+// records insert their chunks either into a map or into a ReferencedChunkList, these add one
+// record's chunks to either
+inline void AddChunkRun(std::map<int32_t, Chunk *> &recordlist,
+                        const std::vector<rdcpair<int32_t, Chunk *>> &run)
+{
+  for(auto it = run.begin(); it != run.end(); ++it)
+    recordlist[it->first] = it->second;
+}
+
+inline void AddChunkRun(ReferencedChunkList &recordlist,
+                        const std::vector<rdcpair<int32_t, Chunk *>> &run)
+{
+  recordlist.AddRun(run);
+}
+
 class ResourceRecordHandler
 {
 public:
@@ -338,7 +379,8 @@ struct ResourceRecord
   }
 
   void MarkDataUnwritten() { DataWritten = false; }
-  void Insert(std::map<int32_t, Chunk *> &recordlist)
+  template <typename ChunkList>
+  void Insert(ChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -353,10 +395,7 @@ struct ResourceRecord
     }
 
     if(!dataWritten)
-    {
-      for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
-        recordlist[it->first] = it->second;
-    }
+      AddChunkRun(recordlist, m_Chunks);
   }
 
   void AddRef() { Atomic::Inc32(&RefCount); }
@@ -620,6 +659,9 @@ public:
   // Free any initial contents that are prepared (for after capture is complete)
   void FreeInitialContents();
 
+  // Free any serialised initial contents retained between captures
+  void FreeInitialContentsCache();
+
   // Apply the initial contents for the resources that need them, used at the start of a frame
   void ApplyInitialContents();
 
@@ -644,6 +686,14 @@ public:
 protected:
   friend InitialContentData;
   // 'interface' to implement by derived classes
+
+  // returns true if every write to this resource is reported via MarkDirtyResource, so that an
+  // unchanged write generation guarantees its contents are unchanged since the last capture. Only
+  // these resources can reuse serialised initial contents between captures.
+  virtual bool IsInitialStateCacheable(WrappedResourceType res) { return false; }
+  // called instead of Prepare_InitialState when cached initial contents are reused, to do any
+  // bookkeeping that preparation would otherwise have done.
+  virtual void Reuse_InitialState(WrappedResourceType res) {}
   virtual ResourceId GetID(WrappedResourceType res) = 0;
 
   virtual bool ResourceTypeRelease(WrappedResourceType res) = 0;
@@ -683,6 +733,28 @@ protected:
   // used during capture - holds resources marked as dirty, needing initial contents
   std::set<ResourceId> m_DirtyResources;
 
+  // used during capture - incremented each time a resource is marked dirty, so that initial
+  // contents cached from a previous capture can be reused if the resource hasn't been written since
+  std::map<ResourceId, uint32_t> m_DirtyGenerations;
+
+  struct CachedInitialContents
+  {
+    uint32_t generation = 0;
+    Chunk *chunk = NULL;
+  };
+
+  // used during capture - initial contents chunks kept from the previous capture, only populated
+  // if m_CacheInitialContents is enabled.
+  std::map<ResourceId, CachedInitialContents> m_InitialContentsCache;
+
+  // used during capture - resources prepared this capture which should be cached once serialised,
+  // along with the generation they were prepared at.
+  std::map<ResourceId, uint32_t> m_PendingInitialContentsCache;
+
+  bool m_CacheInitialContents = false;
+  uint32_t m_InitialContentsCacheHits = 0;
+  uint32_t m_InitialContentsCacheMisses = 0;
+
   struct InitialContentDataOrChunk
   {
     Chunk *chunk = NULL;
@@ -743,12 +815,18 @@ ResourceManager<Configuration>::ResourceManager(CaptureState &state) : m_State(s
 {
   if(RenderDoc::Inst().GetCrashHandler())
     RenderDoc::Inst().GetCrashHandler()->RegisterMemoryRegion(this, sizeof(ResourceManager));
+
+  // retaining initial contents trades memory for capture time, so it's opt-in for when captures
+  // are taken back-to-back.
+  const char *cacheEnv = Process::GetEnvVariable("RENDERDOC_CACHE_INITIAL_CONTENTS");
+  m_CacheInitialContents = cacheEnv && cacheEnv[0] && cacheEnv[0] != '0';
 }
 
 template <typename Configuration>
 void ResourceManager<Configuration>::Shutdown()
 {
   FreeInitialContents();
+  FreeInitialContentsCache();
 
   while(!m_LiveResourceMap.empty())
   {
@@ -820,6 +898,9 @@ void ResourceManager<Configuration>::MarkDirtyResource(ResourceId res)
     return;
 
   m_DirtyResources.insert(res);
+
+  if(m_CacheInitialContents)
+    m_DirtyGenerations[res]++;
 }
 
 template <typename Configuration>
@@ -953,6 +1034,19 @@ void ResourceManager<Configuration>::FreeInitialContents()
       m_InitialContents.erase(m_InitialContents.begin());
   }
   m_PostponedResourceIDs.clear();
+  m_PendingInitialContentsCache.clear();
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::FreeInitialContentsCache()
+{
+  SCOPED_LOCK(m_Lock);
+
+  for(auto it = m_InitialContentsCache.begin(); it != m_InitialContentsCache.end(); ++it)
+    SAFE_DELETE(it->second.chunk);
+
+  m_InitialContentsCache.clear();
+  m_PendingInitialContentsCache.clear();
 }
 
 template <typename Configuration>
@@ -1127,7 +1221,7 @@ void ResourceManager<Configuration>::MarkUnwrittenResources()
 template <typename Configuration>
 void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser)
 {
-  std::map<int32_t, Chunk *> sortedChunks;
+  ReferencedChunkList sortedChunks;
 
   SCOPED_LOCK(m_Lock);
 
@@ -1168,8 +1262,7 @@ void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser
 
   RDCDEBUG("%u frame resource chunks", (uint32_t)sortedChunks.size());
 
-  for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
-    it->second->Write(ser);
+  sortedChunks.ProcessSorted([&ser](Chunk *chunk) { chunk->Write(ser); });
 
   RDCDEBUG("inserted to serialiser");
 }
@@ -1182,6 +1275,8 @@ void ResourceManager<Configuration>::PrepareInitialContents()
   RDCDEBUG("Preparing up to %u potentially dirty resources", (uint32_t)m_DirtyResources.size());
   uint32_t prepared = 0;
 
+  m_InitialContentsCacheHits = m_InitialContentsCacheMisses = 0;
+
   float num = float(m_DirtyResources.size());
   float idx = 0.0f;
 
@@ -1213,6 +1308,28 @@ void ResourceManager<Configuration>::PrepareInitialContents()
       continue;
     }
 
+    if(m_CacheInitialContents && IsInitialStateCacheable(res))
+    {
+      uint32_t generation = m_DirtyGenerations[id];
+
+      auto cacheit = m_InitialContentsCache.find(id);
+      if(cacheit != m_InitialContentsCache.end() && cacheit->second.generation == generation)
+      {
+#if ENABLED(VERBOSE_DIRTY_RESOURCES)
+        RDCDEBUG("Reusing cached initial contents for Resource %llu", id);
+#endif
+
+        m_InitialContentsCacheHits++;
+
+        SetInitialChunk(id, cacheit->second.chunk->Duplicate());
+        Reuse_InitialState(res);
+        continue;
+      }
+
+      m_InitialContentsCacheMisses++;
+      m_PendingInitialContentsCache[id] = generation;
+    }
+
     prepared++;
 
 #if ENABLED(VERBOSE_DIRTY_RESOURCES)
@@ -1223,6 +1340,11 @@ void ResourceManager<Configuration>::PrepareInitialContents()
   }
 
   RDCDEBUG("Prepared %u dirty resources", prepared);
+
+  if(m_CacheInitialContents)
+    RDCLOG("Initial contents cache: %u hits, %u misses, %u cached resources",
+           m_InitialContentsCacheHits, m_InitialContentsCacheMisses,
+           (uint32_t)m_InitialContentsCache.size());
 }
 
 template <typename Configuration>
@@ -1289,10 +1411,40 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
       continue;
     }
 
+    auto pendingit = m_PendingInitialContentsCache.find(id);
+
     if(it->second.chunk)
     {
       it->second.chunk->Write(ser);
     }
+    else if(pendingit != m_PendingInitialContentsCache.end())
+    {
+      // serialise into a standalone chunk so it can be kept for the next capture
+      WriteSerialiser scratch(new StreamWriter(StreamWriter::DefaultScratchSize),
+                              Ownership::Stream);
+      scratch.SetChunkMetadataRecording(ser.GetChunkMetadataRecording());
+      scratch.SetUserData(ser.GetUserData());
+
+      uint64_t size = GetSize_InitialState(id, it->second.data);
+
+      Chunk *chunk = NULL;
+      {
+        ScopedChunk scope(scratch, SystemChunk::InitialContents, size);
+
+        Serialise_InitialState(scratch, id, record, &it->second.data);
+
+        chunk = scope.Get();
+      }
+
+      chunk->Write(ser);
+
+      CachedInitialContents &cached = m_InitialContentsCache[id];
+      SAFE_DELETE(cached.chunk);
+      cached.chunk = chunk;
+      cached.generation = pendingit->second;
+
+      m_PendingInitialContentsCache.erase(pendingit);
+    }
     else
     {
       uint64_t size = GetSize_InitialState(id, it->second.data);
@@ -1618,6 +1770,14 @@ void ResourceManager<Configuration>::ReleaseCurrentResource(ResourceId id)
   m_CurrentResourceMap.erase(id);
   m_DirtyResources.erase(id);
   m_LastWriteTime.erase(id);
+  m_DirtyGenerations.erase(id);
+
+  auto cacheit = m_InitialContentsCache.find(id);
+  if(cacheit != m_InitialContentsCache.end())
+  {
+    SAFE_DELETE(cacheit->second.chunk);
+    m_InitialContentsCache.erase(cacheit);
+  }
 }
 
 template <typename Configuration>
@@ -0,0 +1,154 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "resource_manager.h"
+#include "common/globalconfig.h"
+#include "common/timing.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+// the chunk list never dereferences the chunks, so we can use fake pointers that encode an index
+static Chunk *FakeChunk(size_t idx)
+{
+  return (Chunk *)(uintptr_t)(idx + 1);
+}
+
+// build numRecords runs with a total of roughly numChunks chunks, with IDs allocated incrementally
+// and interleaved across records the way they would be during a capture.
+static std::vector<std::vector<rdcpair<int32_t, Chunk *>>> MakeRuns(size_t numRecords,
+                                                                     size_t numChunks)
+{
+  std::vector<std::vector<rdcpair<int32_t, Chunk *>>> runs;
+  runs.resize(numRecords);
+
+  uint32_t seed = 0x1234567;
+  for(size_t i = 0; i < numChunks; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    size_t r = (seed >> 8) % numRecords;
+    runs[r].push_back({int32_t(i + 10), FakeChunk(i)});
+  }
+
+  return runs;
+}
+
+static std::vector<Chunk *> SortWithMap(const std::vector<std::vector<rdcpair<int32_t, Chunk *>>> &runs)
+{
+  std::map<int32_t, Chunk *> sorted;
+  for(const std::vector<rdcpair<int32_t, Chunk *>> &run : runs)
+    for(const rdcpair<int32_t, Chunk *> &c : run)
+      sorted[c.first] = c.second;
+
+  std::vector<Chunk *> ret;
+  ret.reserve(sorted.size());
+  for(auto it = sorted.begin(); it != sorted.end(); ++it)
+    ret.push_back(it->second);
+  return ret;
+}
+
+static std::vector<Chunk *> SortWithList(const std::vector<std::vector<rdcpair<int32_t, Chunk *>>> &runs)
+{
+  ReferencedChunkList list;
+  for(const std::vector<rdcpair<int32_t, Chunk *>> &run : runs)
+    list.AddRun(run);
+
+  std::vector<Chunk *> ret;
+  ret.reserve(list.size());
+  list.ProcessSorted([&ret](Chunk *c) { ret.push_back(c); });
+  return ret;
+}
+
+TEST_CASE("Test referenced chunk list sorting", "[resourcemanager]")
+{
+  SECTION("empty list")
+  {
+    ReferencedChunkList list;
+    int count = 0;
+    list.ProcessSorted([&count](Chunk *) { count++; });
+    CHECK(count == 0);
+  }
+
+  SECTION("records added in arbitrary order")
+  {
+    std::vector<std::vector<rdcpair<int32_t, Chunk *>>> runs = {
+        {{50, FakeChunk(50)}, {60, FakeChunk(60)}},
+        {{10, FakeChunk(10)}, {20, FakeChunk(20)}, {70, FakeChunk(70)}},
+        {},
+        {{30, FakeChunk(30)}},
+    };
+
+    std::vector<Chunk *> expected = {FakeChunk(10), FakeChunk(20), FakeChunk(30),
+                                     FakeChunk(50), FakeChunk(60), FakeChunk(70)};
+
+    CHECK(SortWithList(runs) == expected);
+  }
+
+  SECTION("unsorted runs and duplicate IDs")
+  {
+    // explicit IDs can be given to chunks so runs may not be sorted, and the same ID can appear
+    // twice in which case the last one added wins.
+    std::vector<std::vector<rdcpair<int32_t, Chunk *>>> runs = {
+        {{40, FakeChunk(1)}, {1, FakeChunk(2)}, {20, FakeChunk(3)}},
+        {{20, FakeChunk(4)}, {5, FakeChunk(5)}},
+        {{1, FakeChunk(6)}},
+    };
+
+    CHECK(SortWithList(runs) == SortWithMap(runs));
+  }
+
+  SECTION("many records across multiple segments")
+  {
+    std::vector<std::vector<rdcpair<int32_t, Chunk *>>> runs = MakeRuns(10000, 500000);
+
+    // add duplicates spanning different segments
+    runs[9999].push_back({100, FakeChunk(9999999)});
+    runs[5000].push_back({200000, FakeChunk(8888888)});
+
+    CHECK(SortWithList(runs) == SortWithMap(runs));
+  }
+};
+
+TEST_CASE("Benchmark referenced chunk list sorting", "[.][benchmark][resourcemanager]")
+{
+  std::vector<std::vector<rdcpair<int32_t, Chunk *>>> runs = MakeRuns(1000000, 10000000);
+
+  std::vector<Chunk *> viaMap, viaList;
+
+  PerformanceTimer timer;
+  viaMap = SortWithMap(runs);
+  double mapTime = timer.GetMilliseconds();
+
+  timer.Restart();
+  viaList = SortWithList(runs);
+  double listTime = timer.GetMilliseconds();
+
+  WARN("std::map: " << mapTime << "ms, chunk list: " << listTime << "ms with "
+                    << Threading::GetNumHardwareThreads() << " threads");
+
+  CHECK(viaMap == viaList);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -25,12 +25,13 @@
 
 #include "android/android.h"
 #include "api/replay/renderdoc_replay.h"
+#include "core/capture_transfer.h"
 #include "core/core.h"
 #include "jpeg-compressor/jpgd.h"
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
 
-static const uint32_t TargetControlProtocolVersion = 5;
+static const uint32_t TargetControlProtocolVersion = 7;
 
 static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
 {
@@ -46,6 +47,14 @@ static bool IsProtocolVersionSupported(const uint32_t protocolVersion)
   if(protocolVersion == 4)
     return true;
 
+  // 5 -> 6 added capture cost request packets
+  if(protocolVersion == 5)
+    return true;
+
+  // 6 -> 7 capture copies are sent in compressed blocks and can resume
+  if(protocolVersion == 6)
+    return true;
+
   if(protocolVersion == TargetControlProtocolVersion)
     return true;
 
@@ -66,7 +75,8 @@ enum PacketType : uint32_t
   ePacket_NewChild,
   ePacket_CaptureProgress,
   ePacket_CycleActiveWindow,
-  ePacket_CapturableWindowCount
+  ePacket_CapturableWindowCount,
+  ePacket_CaptureCosts,
 };
 
 DECLARE_REFLECTION_ENUM(PacketType);
@@ -89,6 +99,7 @@ rdcstr DoStringise(const PacketType &el)
     STRINGISE_ENUM_NAMED(ePacket_CaptureProgress, "Capture Progress");
     STRINGISE_ENUM_NAMED(ePacket_CycleActiveWindow, "Cycle Active Window");
     STRINGISE_ENUM_NAMED(ePacket_CapturableWindowCount, "Capturable Window Count");
+    STRINGISE_ENUM_NAMED(ePacket_CaptureCosts, "Capture Costs");
   }
   END_ENUM_STRINGISE();
 }
@@ -325,10 +336,17 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
         caps = RenderDoc::Inst().GetCaptures();
 
         uint32_t id;
+        CaptureTransfer::ResumePoint resume;
 
         {
           READ_DATA_SCOPE();
           SERIALISE_ELEMENT(id);
+
+          if(version >= 7)
+          {
+            SERIALISE_ELEMENT(resume.offset);
+            SERIALISE_ELEMENT(resume.blockHash);
+          }
         }
 
         if(id < caps.size())
@@ -339,10 +357,21 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
 
           std::string filename = caps[id].path;
 
-          StreamReader fileStream(FileIO::fopen(filename.c_str(), "rb"));
-          ser.SerialiseStream(filename, fileStream);
+          bool success = false;
 
-          if(fileStream.IsErrored() || ser.IsErrored())
+          if(version >= 7)
+          {
+            success = CaptureTransfer::Send(*ser.GetWriter(), filename, resume);
+          }
+          else
+          {
+            StreamReader fileStream(FileIO::fopen(filename.c_str(), "rb"));
+            ser.SerialiseStream(filename, fileStream);
+
+            success = !fileStream.IsErrored();
+          }
+
+          if(!success || ser.IsErrored())
             SAFE_DELETE(client);
           else
             RenderDoc::Inst().MarkCaptureRetrieved(id);
@@ -352,6 +381,26 @@ void RenderDoc::TargetControlClientThread(uint32_t version, Network::Socket *cli
       {
         RenderDoc::Inst().CycleActiveWindow();
       }
+      else if(type == ePacket_CaptureCosts)
+      {
+        bool reset = false;
+
+        {
+          READ_DATA_SCOPE();
+          SERIALISE_ELEMENT(reset);
+        }
+
+        CaptureCost::SetEnabled(true);
+
+        rdcarray<CaptureCostData> costs = CaptureCost::Gather();
+
+        if(reset)
+          CaptureCost::Reset();
+
+        WRITE_DATA_SCOPE();
+        SCOPED_SERIALISE_CHUNK(ePacket_CaptureCosts);
+        SERIALISE_ELEMENT(costs);
+      }
 
       reader.EndChunk();
 
@@ -613,6 +662,15 @@ public:
 
     SERIALISE_ELEMENT(remoteID);
 
+    if(m_Version >= 7)
+    {
+      // pick up from any earlier copy to the same path that was interrupted
+      CaptureTransfer::ResumePoint resume = CaptureTransfer::GetResumePoint(localpath);
+
+      SERIALISE_ELEMENT(resume.offset);
+      SERIALISE_ELEMENT(resume.blockHash);
+    }
+
     if(ser.IsErrored())
     {
       SAFE_DELETE(m_Socket);
@@ -645,6 +703,19 @@ public:
       SAFE_DELETE(m_Socket);
   }
 
+  void RequestCaptureCosts(bool reset)
+  {
+    if(m_Version < 6)
+      return;
+
+    WRITE_DATA_SCOPE();
+    SCOPED_SERIALISE_CHUNK(ePacket_CaptureCosts);
+    SERIALISE_ELEMENT(reset);
+
+    if(ser.IsErrored())
+      SAFE_DELETE(m_Socket);
+  }
+
   TargetControlMessage ReceiveMessage(RENDERDOC_ProgressCallback progress)
   {
     TargetControlMessage msg;
@@ -813,11 +884,21 @@ public:
 
       msg.newCapture.path = m_CaptureCopies[msg.newCapture.captureId];
 
-      StreamWriter streamWriter(FileIO::fopen(msg.newCapture.path.c_str(), "wb"), Ownership::Stream);
+      bool success = true;
+
+      if(m_Version >= 7)
+      {
+        success = CaptureTransfer::Receive(*ser.GetReader(), msg.newCapture.path, progress);
+      }
+      else
+      {
+        StreamWriter streamWriter(FileIO::fopen(msg.newCapture.path.c_str(), "wb"),
+                                  Ownership::Stream);
 
-      ser.SerialiseStream(msg.newCapture.path.c_str(), streamWriter, progress);
+        ser.SerialiseStream(msg.newCapture.path.c_str(), streamWriter, progress);
+      }
 
-      if(reader.IsErrored())
+      if(!success || reader.IsErrored())
       {
         SAFE_DELETE(m_Socket);
 
@@ -840,6 +921,14 @@ public:
       reader.EndChunk();
       return msg;
     }
+    else if(type == ePacket_CaptureCosts)
+    {
+      msg.type = TargetControlMessageType::CaptureCosts;
+      READ_DATA_SCOPE();
+      SERIALISE_ELEMENT(msg.captureCosts);
+      reader.EndChunk();
+      return msg;
+    }
     else
     {
       RDCERR("Unexpected packed received: %d", type);
@@ -156,6 +156,7 @@ WrappedID3D11DeviceContext::WrappedID3D11DeviceContext(WrappedID3D11Device *real
   }
 
   m_ScratchSerialiser.SetUserData(GetResourceManager());
+  m_ScratchSerialiser.SetChunkLookup(&GetChunkName);
   m_ScratchSerialiser.SetVersion(D3D11InitParams::CurrentVersion);
 
   m_SuccessfulCapture = true;
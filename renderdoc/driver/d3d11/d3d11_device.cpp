@@ -132,6 +132,7 @@ WrappedID3D11Device::WrappedID3D11Device(ID3D11Device *realDevice, D3D11InitPara
   m_ShaderCache = new D3D11ShaderCache(this);
 
   m_ScratchSerialiser.SetUserData(GetResourceManager());
+  m_ScratchSerialiser.SetChunkLookup(&GetChunkName);
 
   // create a temporary and grab its resource ID
   m_ResourceID = ResourceIDGen::GetNewUniqueID();
@@ -158,7 +158,8 @@ struct D3D11ResourceRecord : public ResourceRecord
       SubResources[i]->SetDataPtr(ptr);
   }
 
-  void Insert(std::map<int32_t, Chunk *> &recordlist)
+  template <typename ChunkList>
+  void Insert(ChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -174,8 +175,7 @@ struct D3D11ResourceRecord : public ResourceRecord
 
     if(!dataWritten)
     {
-      for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
-        recordlist[it->first] = it->second;
+      AddChunkRun(recordlist, m_Chunks);
 
       for(int i = 0; i < NumSubResources; i++)
         SubResources[i]->Insert(recordlist);
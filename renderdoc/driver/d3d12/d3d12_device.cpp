@@ -2512,6 +2512,7 @@ WriteSerialiser &WrappedID3D12Device::GetThreadSerialiser()
 
   ser->SetChunkMetadataRecording(flags);
   ser->SetUserData(GetResourceManager());
+  ser->SetChunkLookup(&GetChunkName);
   ser->SetVersion(D3D12InitParams::CurrentVersion);
 
   Threading::SetTLSValue(threadSerialiserTLSSlot, (void *)ser);
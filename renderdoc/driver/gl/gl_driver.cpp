@@ -674,6 +674,7 @@ WrappedOpenGL::WrappedOpenGL(GLPlatform &platform)
   m_ResourceManager = new GLResourceManager(m_State, this);
 
   m_ScratchSerialiser.SetUserData(GetResourceManager());
+  m_ScratchSerialiser.SetChunkLookup(&GetChunkName);
 
   m_DeviceResourceID =
       GetResourceManager()->RegisterResource(GLResource(NULL, eResSpecial, eSpecialResDevice));
@@ -118,37 +118,79 @@ static rdcstr StringiseBinaryOperation(const std::function<rdcstr(rdcspv::Id)> &
 namespace rdcspv
 {
 std::string Reflector::Disassemble(const std::string &entryPoint) const
+{
+  std::string ret;
+  DisassembleInto(entryPoint, ret, std::function<bool(const std::string &)>(), 0);
+  return ret;
+}
+
+void Reflector::Disassemble(const std::string &entryPoint,
+                            const std::function<bool(const std::string &)> &output,
+                            size_t chunkSize) const
+{
+  std::string buffer;
+  DisassembleInto(entryPoint, buffer, output, chunkSize);
+
+  if(!buffer.empty())
+    output(buffer);
+}
+
+void Reflector::DisassembleInto(const std::string &entryPoint, std::string &ret,
+                                const std::function<bool(const std::string &)> &output,
+                                size_t chunkSize) const
 {
   std::set<rdcstr> usedNames;
-  std::map<Id, rdcstr> dynamicNames;
 
-  auto idName = [this, &dynamicNames](Id id) -> rdcstr {
-    // see if we have a dynamic name assigned (to disambiguate), if so use that
-    auto it = dynamicNames.find(id);
-    if(it != dynamicNames.end())
-      return it->second;
+  // names are looked up for every operand, so cache them per Id rather than re-deriving them. This
+  // also holds the dynamic names assigned to disambiguate declarations, which take precedence.
+  DenseIdMap<rdcstr> idNames;
+  idNames.resize(strings.size());
+  DenseIdMap<rdcstr> typeNames;
+  typeNames.resize(strings.size());
+
+  auto idName = [this, &idNames](Id id) -> rdcstr {
+    if(id.value() >= idNames.size())
+      return "_" + ToStr(id.value());
+
+    rdcstr &name = idNames[id];
+    if(!name.empty())
+      return name;
 
     // otherwise try the string
-    rdcstr ret = strings[id];
-    if(!ret.empty())
-      return ret;
+    name = strings[id];
+    if(!name.empty())
+      return name;
 
     // for non specialised constants, see if we can stringise them directly if they're unnamed
-    ret = StringiseConstant(id);
-    if(!ret.empty())
-      return ret;
+    name = StringiseConstant(id);
+    if(!name.empty())
+      return name;
 
     // if we *still* have nothing, just stringise the id itself
-    return StringFormat::Fmt("_%u", id);
+    name = "_" + ToStr(id.value());
+    return name;
   };
   auto constIntVal = [this](Id id) { return EvaluateConstant(id, {}).value.u.x; };
-  auto declName = [this, &idName, &usedNames, &dynamicNames](Id typeId, Id id) -> rdcstr {
+  auto declName = [this, &idName, &usedNames, &idNames, &typeNames](Id typeId, Id id) -> rdcstr {
     if(typeId == Id())
       return idName(id);
 
-    rdcstr ret = dataTypes[typeId].name;
-    if(ret.empty())
-      ret = StringFormat::Fmt("type%u", typeId);
+    rdcstr ret;
+    if(typeId.value() < typeNames.size())
+    {
+      rdcstr &typeName = typeNames[typeId];
+      if(typeName.empty())
+      {
+        typeName = dataTypes[typeId].name;
+        if(typeName.empty())
+          typeName = "type" + ToStr(typeId.value());
+      }
+      ret = typeName;
+    }
+    else
+    {
+      ret = "type" + ToStr(typeId.value());
+    }
 
     if(id == Id())
       return ret;
@@ -156,7 +198,7 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
     rdcstr basename = strings[id];
     if(basename.empty())
     {
-      return ret + " " + StringFormat::Fmt("_%u", id);
+      return ret + " " + idName(id);
     }
 
     rdcstr name = basename;
@@ -169,7 +211,7 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
     }
 
     usedNames.insert(name);
-    dynamicNames[id] = name;
+    idNames[id] = name;
 
     return ret + " " + name;
   };
@@ -248,9 +290,15 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
     return StringFormat::Fmt("._child%u", idx);
   };
 
-  std::string ret;
   std::string indent;
 
+  // when streaming, the same buffer is reused for each chunk so it only grows once. Otherwise
+  // reserve a rough estimate of the whole output
+  if(output)
+    ret.reserve(chunkSize + 1024);
+  else
+    ret.reserve(m_SPIRV.size() * 4);
+
   // stack of structured CFG constructs
   std::vector<StructuredCFG> cfgStack;
 
@@ -259,7 +307,7 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
 
   Id currentBlock;
 
-  ret = StringFormat::Fmt(
+  ret += StringFormat::Fmt(
       "SPIR-V %u.%u module, <id> bound of %u\n\nGenerator: %s\nGenerator Version: %u\n\n",
       m_MajorVersion, m_MinorVersion, m_SPIRV[3], ToStr(m_Generator).c_str(), m_GeneratorVersion);
 
@@ -270,6 +318,17 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
 
     for(; it < end; it++)
     {
+      // hand off complete lines once enough text has built up
+      if(output && ret.size() >= chunkSize && ret.back() == '\n')
+      {
+        if(!output(ret))
+        {
+          ret.clear();
+          return;
+        }
+        ret.clear();
+      }
+
       // special case some opcodes for more readable disassembly, but generally pass to the
       // auto-generated disassembler
       switch(it.opcode())
@@ -968,7 +1027,7 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
               else
               {
                 if(strings[otherLabel].empty())
-                  dynamicNames[otherLabel] = StringFormat::Fmt("_continue%u", otherLabel);
+                  idNames[otherLabel] = StringFormat::Fmt("_continue%u", otherLabel);
                 ret += StringFormat::Fmt("if(%s%s) goto %s;", negate,
                                          idName(decoded.condition).c_str(),
                                          idName(otherLabel).c_str());
@@ -1412,8 +1471,6 @@ std::string Reflector::Disassemble(const std::string &entryPoint) const
 
     ret += "\n";
   }
-
-  return ret;
 }
 
 rdcstr Reflector::StringiseConstant(rdcspv::Id id) const
@@ -1482,3 +1539,153 @@ rdcstr Reflector::StringiseConstant(rdcspv::Id id) const
 }
 
 };    // namespace rdcspv
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
+#include "core/core.h"
+#include "spirv_compile.h"
+#include "spirv_editor.h"
+
+// compiles a small shader and pads its body out with numOps extra instructions
+static std::vector<uint32_t> CompileDisassemblyShader(size_t numOps)
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  rdcspv::CompilationSettings settings;
+  settings.entryPoint = "main";
+  settings.lang = rdcspv::InputLanguage::VulkanGLSL;
+  settings.stage = rdcspv::ShaderStage::Fragment;
+
+  std::vector<std::string> sources = {
+      R"(#version 450 core
+
+layout(binding = 0) uniform block {
+  vec4 tint;
+};
+
+layout(location = 0) out vec4 col;
+
+void main() {
+  col = vec4(sin(gl_FragCoord.x), 0, 0, 1) * tint;
+}
+)",
+  };
+
+  std::vector<uint32_t> spirv;
+  std::string errors = rdcspv::Compile(settings, sources, spirv);
+
+  INFO("SPIR-V compilation - " << errors);
+  REQUIRE(spirv.size() > 0);
+
+  rdcspv::Editor ed(spirv);
+
+  ed.Prepare();
+
+  rdcspv::Id floatType = ed.DeclareType(rdcspv::scalar<float>());
+  rdcspv::Id constant = ed.AddConstantImmediate<float>(1.0f);
+
+  rdcspv::Iter it = ed.GetID(ed.GetEntries()[0].id);
+  while(it.opcode() != rdcspv::Op::Label)
+    it++;
+  it++;
+
+  rdcspv::Id prev = constant;
+  for(size_t i = 0; i < numOps; i++)
+  {
+    rdcspv::Id id = ed.MakeId();
+    ed.AddOperation(it, rdcspv::OpFAdd(floatType, id, prev, constant));
+    prev = id;
+  }
+
+  return spirv;
+}
+
+TEST_CASE("Test SPIR-V streaming disassembly", "[spirv]")
+{
+  std::vector<uint32_t> spirv = CompileDisassemblyShader(2000);
+
+  rdcspv::Reflector refl;
+  refl.Parse(spirv);
+
+  std::string full = refl.Disassemble("main");
+
+  REQUIRE(full.size() > 16 * 1024);
+
+  SECTION("Streamed chunks match the complete disassembly")
+  {
+    std::string streamed;
+    std::vector<size_t> chunkSizes;
+
+    refl.Disassemble("main",
+                     [&streamed, &chunkSizes](const std::string &text) {
+                       streamed += text;
+                       chunkSizes.push_back(text.size());
+                       CHECK(text.back() == '\n');
+                       return true;
+                     },
+                     4096);
+
+    CHECK(streamed == full);
+    REQUIRE(chunkSizes.size() > 2);
+
+    // all but the last chunk are at least as big as requested
+    for(size_t i = 0; i + 1 < chunkSizes.size(); i++)
+      CHECK(chunkSizes[i] >= 4096);
+  };
+
+  SECTION("Stopping early returns only the first lines")
+  {
+    std::string first;
+    int calls = 0;
+
+    refl.Disassemble("main",
+                     [&first, &calls](const std::string &text) {
+                       first = text;
+                       calls++;
+                       return false;
+                     },
+                     4096);
+
+    CHECK(calls == 1);
+    CHECK(first.size() < full.size());
+    CHECK(full.compare(0, first.size(), first) == 0);
+  };
+};
+
+TEST_CASE("Benchmark SPIR-V disassembly throughput", "[.][benchmark][spirv]")
+{
+  const size_t numOps = 1000000;
+
+  std::vector<uint32_t> spirv = CompileDisassemblyShader(numOps);
+
+  rdcspv::Reflector refl;
+  refl.Parse(spirv);
+
+  PerformanceTimer timer;
+
+  std::string disasm = refl.Disassemble("main");
+
+  double fullTime = timer.GetMilliseconds();
+
+  timer.Restart();
+
+  double firstTime = 0.0;
+  refl.Disassemble("main",
+                   [&firstTime, &timer](const std::string &) {
+                     firstTime = timer.GetMilliseconds();
+                     return false;
+                   },
+                   64 * 1024);
+
+  WARN("Disassembling " << numOps << " instructions: " << fullTime << "ms ("
+                        << uint64_t(double(numOps) / (fullTime / 1000.0))
+                        << " instructions/second). First 64kB streamed after " << firstTime
+                        << "ms");
+
+  CHECK(disasm.size() > numOps);
+};
+
+#endif
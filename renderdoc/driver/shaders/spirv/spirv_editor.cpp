@@ -28,6 +28,7 @@
 #include "common/common.h"
 #include "serialise/serialiser.h"
 #include "spirv_op_helpers.h"
+#include "spirv_reflect.h"
 
 namespace rdcspv
 {
@@ -58,9 +59,44 @@ Editor::Editor(std::vector<uint32_t> &spirvWords) : m_ExternalSPIRV(spirvWords)
 {
 }
 
+Editor::Editor(std::vector<uint32_t> &spirvWords, const Processor &parsed)
+    : m_ExternalSPIRV(spirvWords), m_Parsed(&parsed)
+{
+}
+
 void Editor::Prepare()
 {
-  Processor::Parse(m_ExternalSPIRV);
+  if(m_Parsed)
+  {
+    const std::vector<uint32_t> &parsedWords = m_Parsed->GetSPIRV();
+
+    // leave room for new IDs before copying, so the first MakeId() doesn't reallocate all the
+    // per-ID arrays straight away. Assigning into them keeps this capacity.
+    if(parsedWords.size() >= FirstRealWord)
+    {
+      const size_t reserveIds = parsedWords[3] + parsedWords[3] / 4;
+      idOffsets.reserve(reserveIds);
+      idTypes.reserve(reserveIds);
+      decorations.reserve(reserveIds);
+    }
+
+    // copy the parsed state wholesale, then we only need to walk the annotations and types to
+    // build our own lookup tables rather than decoding every instruction in the module again.
+    Processor::operator=(*m_Parsed);
+    m_Parsed = NULL;
+
+    if(!m_SPIRV.empty())
+    {
+      for(Iter it(m_SPIRV, m_Sections[Section::Annotations].startOffset),
+          end(m_SPIRV, m_Sections[Section::TypesVariablesConstants].endOffset);
+          it < end; it++)
+        RegisterLookups(it);
+    }
+  }
+  else
+  {
+    Processor::Parse(m_ExternalSPIRV);
+  }
 
   if(m_SPIRV.empty())
     return;
@@ -108,26 +144,69 @@ void Editor::Prepare()
 
 Editor::~Editor()
 {
-  for(size_t i = FirstRealWord; i < m_SPIRV.size();)
+  if(m_SPIRV.size() <= FirstRealWord)
   {
-    while(m_SPIRV[i] == OpNopWord)
+    m_ExternalSPIRV.swap(m_SPIRV);
+    return;
+  }
+
+  // build the final module in a single pass, emitting pending insertions in front of the words
+  // they were added at and skipping over any nops
+  std::vector<uint32_t> spirv;
+  spirv.reserve(m_SPIRV.size() + m_PendingWords);
+  spirv.insert(spirv.end(), m_SPIRV.begin(), m_SPIRV.begin() + FirstRealWord);
+
+  auto pending = m_PendingInserts.begin();
+
+  size_t i = FirstRealWord;
+  while(i < m_SPIRV.size())
+  {
+    for(; pending != m_PendingInserts.end() && pending->first <= i; ++pending)
+      spirv.insert(spirv.end(), pending->second.begin(), pending->second.end());
+
+    if(m_SPIRV[i] == OpNopWord)
     {
-      m_SPIRV.erase(m_SPIRV.begin() + i);
-      addWords(i, -1);
+      i++;
+      continue;
     }
 
-    uint32_t len = m_SPIRV[i] >> WordCountShift;
+    // copy the whole run of operations up to the next nop or pending insertion at once
+    const size_t runEnd = pending != m_PendingInserts.end()
+                              ? RDCMIN(pending->first, m_SPIRV.size())
+                              : m_SPIRV.size();
+    const size_t runStart = i;
+
+    bool malformed = false;
 
-    if(len == 0)
+    while(i < runEnd && m_SPIRV[i] != OpNopWord)
+    {
+      uint32_t len = m_SPIRV[i] >> WordCountShift;
+
+      if(len == 0 || i + len > m_SPIRV.size())
+      {
+        malformed = true;
+        break;
+      }
+
+      i += len;
+    }
+
+    spirv.insert(spirv.end(), m_SPIRV.begin() + runStart, m_SPIRV.begin() + i);
+
+    if(malformed)
     {
       RDCERR("Malformed SPIR-V");
       break;
     }
-
-    i += len;
   }
 
-  m_ExternalSPIRV.swap(m_SPIRV);
+  // copy anything remaining after malformed SPIR-V verbatim, then any insertions at the very end
+  spirv.insert(spirv.end(), m_SPIRV.begin() + i, m_SPIRV.end());
+
+  for(; pending != m_PendingInserts.end(); ++pending)
+    spirv.insert(spirv.end(), pending->second.begin(), pending->second.end());
+
+  m_ExternalSPIRV.swap(spirv);
 }
 
 Id Editor::MakeId()
@@ -332,17 +411,21 @@ void Editor::AddOperation(Iter iter, const Operation &op)
   if(!iter)
     return;
 
-  // add op
-  op.insertInto(m_SPIRV, iter.offs());
-
-  // update offsets
-  addWords(iter.offs(), op.size());
+  // queue the op to be inserted when we're finished. Inserting directly would shift every word
+  // after it, which is quadratic when patching many instructions in a large module.
+  op.appendTo(m_PendingInserts[iter.offs()]);
+  m_PendingWords += op.size();
 }
 
 void Editor::RegisterOp(Iter it)
 {
   Processor::RegisterOp(it);
 
+  RegisterLookups(it);
+}
+
+void Editor::RegisterLookups(Iter it)
+{
   OpDecoder opdata(it);
 
   if(opdata.op == Op::TypeVoid || opdata.op == Op::TypeBool || opdata.op == Op::TypeInt ||
@@ -498,6 +581,18 @@ void Editor::addWords(size_t offs, int32_t num)
   for(size_t &o : idOffsets)
     if(o >= offs)
       o += num;
+
+  // pending insertions stay in front of the same words they were added at
+  auto pending = m_PendingInserts.lower_bound(offs);
+  if(pending != m_PendingInserts.end())
+  {
+    std::map<size_t, std::vector<uint32_t>> shifted;
+    for(auto it = pending; it != m_PendingInserts.end(); ++it)
+      shifted[it->first + num].swap(it->second);
+
+    m_PendingInserts.erase(pending, m_PendingInserts.end());
+    m_PendingInserts.insert(shifted.begin(), shifted.end());
+  }
 }
 
 Operation Editor::MakeDeclaration(const Scalar &s)
@@ -576,6 +671,7 @@ TYPETABLE(FunctionType, functionTypeToId);
 #if ENABLED(ENABLE_UNIT_TESTS)
 
 #include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
 #include "core/core.h"
 #include "spirv_common.h"
 #include "spirv_compile.h"
@@ -754,4 +850,339 @@ void main() {
   }
 }
 
-#endif
\ No newline at end of file
+static std::vector<uint32_t> CompileInsertionShader()
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  rdcspv::CompilationSettings settings;
+  settings.entryPoint = "main";
+  settings.lang = rdcspv::InputLanguage::VulkanGLSL;
+  settings.stage = rdcspv::ShaderStage::Fragment;
+
+  std::vector<std::string> sources = {
+      R"(#version 450 core
+
+layout(location = 0) out vec4 col;
+
+void main() {
+  col = vec4(sin(gl_FragCoord.x), 0, 0, 1);
+}
+)",
+  };
+
+  std::vector<uint32_t> spirv;
+  std::string errors = rdcspv::Compile(settings, sources, spirv);
+
+  INFO("SPIR-V compilation - " << errors);
+
+  REQUIRE(spirv.size() > 0);
+
+  return spirv;
+}
+
+// returns the first operation after the entry point's label
+static rdcspv::Iter FirstBodyOp(rdcspv::Editor &ed)
+{
+  rdcspv::Iter it = ed.GetID(ed.GetEntries()[0].id);
+
+  while(it.opcode() != rdcspv::Op::Label)
+    it++;
+
+  it++;
+
+  return it;
+}
+
+TEST_CASE("Test SPIR-V editor buffered insertions", "[spirv]")
+{
+  std::vector<uint32_t> spirv = CompileInsertionShader();
+
+  rdcspv::Id floatType, constant, first, second;
+  std::vector<uint32_t> bodyOp;
+
+  {
+    rdcspv::Editor ed(spirv);
+
+    ed.Prepare();
+
+    floatType = ed.DeclareType(rdcspv::scalar<float>());
+    constant = ed.AddConstantImmediate<float>(1.0f);
+
+    rdcspv::Iter it = FirstBodyOp(ed);
+
+    for(size_t i = 0; i < it.size(); i++)
+      bodyOp.push_back(it.word(i));
+
+    first = ed.MakeId();
+    second = ed.MakeId();
+
+    ed.AddOperation(it, rdcspv::OpCopyObject(floatType, first, constant));
+
+    // the iterator still points at the original operation
+    CHECK(it.opcode() == (rdcspv::Op)(bodyOp[0] & rdcspv::OpCodeMask));
+
+    ed.AddOperation(it, rdcspv::OpCopyObject(floatType, second, first));
+
+    // a declaration added afterwards moves the function, and the pending insertions with it
+    ed.AddConstantImmediate<float>(2.0f);
+
+    // remove the original so nops are stripped around the insertions
+    it = FirstBodyOp(ed);
+    ed.Remove(it);
+  }
+
+  rdcspv::Editor ed(spirv);
+
+  ed.Prepare();
+
+  for(rdcspv::Iter it = ed.Begin(rdcspv::Section::First); it; it++)
+    CHECK(it.opcode() != rdcspv::Op::Nop);
+
+  rdcspv::Iter it = FirstBodyOp(ed);
+
+  REQUIRE(it.opcode() == rdcspv::Op::CopyObject);
+  CHECK(rdcspv::OpCopyObject(it).result == first);
+
+  it++;
+
+  REQUIRE(it.opcode() == rdcspv::Op::CopyObject);
+  CHECK(rdcspv::OpCopyObject(it).result == second);
+
+  it++;
+
+  // the original operation was removed
+  std::vector<uint32_t> nextOp;
+  for(size_t i = 0; i < it.size(); i++)
+    nextOp.push_back(it.word(i));
+
+  CHECK(nextOp != bodyOp);
+};
+
+static std::vector<uint32_t> CompileForkShader(size_t numOps)
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  rdcspv::CompilationSettings settings;
+  settings.entryPoint = "main";
+  settings.lang = rdcspv::InputLanguage::VulkanGLSL;
+  settings.stage = rdcspv::ShaderStage::Fragment;
+
+  std::vector<std::string> sources = {
+      R"(#version 450 core
+
+layout(set = 1, binding = 3) uniform block {
+  vec4 tint;
+};
+
+layout(location = 0) out vec4 col;
+
+void main() {
+  col = vec4(sin(gl_FragCoord.x), 0, 0, 1) * tint;
+}
+)",
+  };
+
+  std::vector<uint32_t> spirv;
+  std::string errors = rdcspv::Compile(settings, sources, spirv);
+
+  INFO("SPIR-V compilation - " << errors);
+
+  REQUIRE(spirv.size() > 0);
+
+  // pad out the function body to get a module of a given size
+  {
+    rdcspv::Editor ed(spirv);
+
+    ed.Prepare();
+
+    rdcspv::Id floatType = ed.DeclareType(rdcspv::scalar<float>());
+    rdcspv::Id constant = ed.AddConstantImmediate<float>(1.0f);
+
+    rdcspv::Iter it = FirstBodyOp(ed);
+
+    for(size_t i = 0; i < numOps; i++)
+      ed.AddOperation(it, rdcspv::OpCopyObject(floatType, ed.MakeId(), constant));
+  }
+
+  return spirv;
+}
+
+struct ForkPatchResult
+{
+  rdcspv::Id floatType, vec4Type, existingFloat;
+  rdcspv::Binding binding;
+};
+
+// a representative patch - look up existing types and bindings and add some code
+static ForkPatchResult PatchForkShader(rdcspv::Editor &ed)
+{
+  ForkPatchResult ret;
+
+  ed.Prepare();
+
+  ret.existingFloat = ed.GetType(rdcspv::scalar<float>());
+  ret.floatType = ed.DeclareType(rdcspv::scalar<float>());
+  ret.vec4Type = ed.DeclareType(rdcspv::Vector(rdcspv::scalar<float>(), 4));
+
+  for(const rdcspv::Variable &var : ed.GetGlobals())
+    if(var.storage == rdcspv::StorageClass::Uniform)
+      ret.binding = ed.GetBinding(var.id);
+
+  rdcspv::Id constant = ed.AddConstantImmediate<float>(2.0f);
+
+  rdcspv::Iter it = FirstBodyOp(ed);
+
+  ed.AddOperation(it, rdcspv::OpCopyObject(ret.floatType, ed.MakeId(), constant));
+
+  return ret;
+}
+
+TEST_CASE("Test SPIR-V editor forked from a parsed module", "[spirv]")
+{
+  std::vector<uint32_t> spirv = CompileForkShader(16);
+
+  rdcspv::Reflector refl;
+  refl.Parse(spirv);
+
+  std::vector<uint32_t> fresh = spirv;
+  ForkPatchResult freshResult;
+  {
+    rdcspv::Editor ed(fresh);
+    freshResult = PatchForkShader(ed);
+  }
+
+  std::vector<uint32_t> forked;
+  ForkPatchResult forkedResult;
+  {
+    rdcspv::Editor ed(forked, refl);
+    forkedResult = PatchForkShader(ed);
+  }
+
+  // the lookup tables are populated from the parsed module
+  CHECK(forkedResult.existingFloat != rdcspv::Id());
+  CHECK(forkedResult.existingFloat == forkedResult.floatType);
+  CHECK(forkedResult.floatType == freshResult.floatType);
+  CHECK(forkedResult.vec4Type == freshResult.vec4Type);
+  CHECK(forkedResult.binding.set == 1);
+  CHECK(forkedResult.binding.binding == 3);
+  bool sameBinding = (forkedResult.binding == freshResult.binding);
+  CHECK(sameBinding);
+
+  CHECK(fresh.size() > spirv.size());
+  CHECK(forked == fresh);
+
+  // the parsed module is untouched and can be forked again
+  CHECK(refl.GetSPIRV() == spirv);
+
+  std::vector<uint32_t> second;
+  {
+    rdcspv::Editor ed(second, refl);
+    PatchForkShader(ed);
+  }
+
+  CHECK(second == fresh);
+};
+
+TEST_CASE("Benchmark SPIR-V editor per-instruction insertions", "[.][benchmark][spirv]")
+{
+  std::vector<uint32_t> spirv = CompileInsertionShader();
+
+  // each OpCopyObject is 4 words, so this grows the module to around 5MB
+  const size_t numOps = (5 * 1024 * 1024) / (4 * sizeof(uint32_t));
+
+  {
+    rdcspv::Editor ed(spirv);
+
+    ed.Prepare();
+
+    rdcspv::Id floatType = ed.DeclareType(rdcspv::scalar<float>());
+    rdcspv::Id constant = ed.AddConstantImmediate<float>(1.0f);
+
+    rdcspv::Iter it = FirstBodyOp(ed);
+
+    for(size_t i = 0; i < numOps; i++)
+      ed.AddOperation(it, rdcspv::OpCopyObject(floatType, ed.MakeId(), constant));
+  }
+
+  size_t moduleSize = spirv.size();
+
+  PerformanceTimer timer;
+
+  {
+    rdcspv::Editor ed(spirv);
+
+    ed.Prepare();
+
+    rdcspv::Id floatType = ed.DeclareType(rdcspv::scalar<float>());
+
+    // insert a copy in front of every copy
+    for(rdcspv::Iter it = ed.Begin(rdcspv::Section::Functions),
+                     end = ed.End(rdcspv::Section::Functions);
+        it < end; ++it)
+    {
+      if(it.opcode() == rdcspv::Op::CopyObject)
+        ed.AddOperation(
+            it, rdcspv::OpCopyObject(floatType, ed.MakeId(), rdcspv::OpCopyObject(it).result));
+    }
+  }
+
+  WARN("Patching " << numOps << " instructions in a " << (moduleSize * sizeof(uint32_t)) / 1024
+                   << "kB module: " << timer.GetMilliseconds() << "ms");
+
+  CHECK(spirv.size() == moduleSize + numOps * 4);
+};
+
+TEST_CASE("Benchmark SPIR-V patching of a reflected module", "[.][benchmark][spirv]")
+{
+  // around 4MB of SPIR-V
+  std::vector<uint32_t> spirv = CompileForkShader(256 * 1024);
+
+  const int numCycles = 20;
+
+  PerformanceTimer timer;
+
+  rdcspv::Reflector refl;
+  refl.Parse(spirv);
+
+  ShaderReflection reflection;
+  ShaderBindpointMapping mapping;
+  SPIRVPatchData patchData;
+  refl.MakeReflection(GraphicsAPI::Vulkan, ShaderStage::Fragment, "main", {}, reflection, mapping,
+                      patchData);
+
+  double reflectTime = timer.GetMilliseconds();
+
+  // patching by re-parsing a copy of the words, as every patch did before
+  timer.Restart();
+
+  for(int i = 0; i < numCycles; i++)
+  {
+    std::vector<uint32_t> modSpirv = refl.GetSPIRV();
+    rdcspv::Editor ed(modSpirv);
+    PatchForkShader(ed);
+  }
+
+  double reparseTime = timer.GetMilliseconds();
+
+  timer.Restart();
+
+  for(int i = 0; i < numCycles; i++)
+  {
+    std::vector<uint32_t> modSpirv;
+    rdcspv::Editor ed(modSpirv, refl);
+    PatchForkShader(ed);
+  }
+
+  double forkTime = timer.GetMilliseconds();
+
+  WARN("Module of " << (spirv.size() * sizeof(uint32_t)) / 1024 << "kB parsed and reflected in "
+                    << reflectTime << "ms");
+  WARN(numCycles << " patches re-parsing the module: " << reparseTime << "ms");
+  WARN(numCycles << " patches forking the parsed module: " << forkTime << "ms");
+
+  CHECK(forkTime > 0.0);
+};
+
+#endif
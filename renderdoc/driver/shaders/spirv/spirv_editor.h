@@ -67,12 +67,19 @@ class Editor : public Processor
 {
 public:
   Editor(std::vector<uint32_t> &spirvWords);
+  // forks an already parsed module instead of parsing the words again. The module's words are
+  // taken from parsed, and spirvWords only receives the edited result when the editor is
+  // destroyed. parsed must outlive the call to Prepare().
+  Editor(std::vector<uint32_t> &spirvWords, const Processor &parsed);
   ~Editor();
 
   void Prepare();
 
   Id MakeId();
 
+  // inserts the operation before iter. Insertions are buffered until the editor is destroyed, so
+  // iter and any other iterators stay pointing at the same operations and multiple operations added
+  // at the same iter are emitted in the order they were added.
   void AddOperation(Iter iter, const Operation &op);
 
   // callbacks to allow us to update our internal structures over changes
@@ -198,6 +205,14 @@ private:
 
   virtual void RegisterOp(Iter iter);
   virtual void UnregisterOp(Iter iter);
+  // registers only the editor's own lookup tables, on top of what Processor tracks
+  void RegisterLookups(Iter iter);
+
+  const Processor *m_Parsed = NULL;
+
+  // operations added with AddOperation, keyed by the offset they will be inserted before
+  std::map<size_t, std::vector<uint32_t>> m_PendingInserts;
+  size_t m_PendingWords = 0;
 
   std::map<Id, Binding> bindings;
 
@@ -93,6 +93,11 @@ public:
   virtual void Parse(const std::vector<uint32_t> &spirvWords);
 
   std::string Disassemble(const std::string &entryPoint) const;
+  // streams the disassembly in pieces of at least chunkSize bytes, each ending on a line boundary,
+  // so the start can be shown before the rest is generated. Return false from output to stop.
+  void Disassemble(const std::string &entryPoint,
+                   const std::function<bool(const std::string &)> &output,
+                   size_t chunkSize = 64 * 1024) const;
 
   std::vector<std::string> EntryPoints() const;
   ShaderStage StageForEntry(const std::string &entryPoint) const;
@@ -108,6 +113,10 @@ private:
   virtual void RegisterOp(Iter iter);
   virtual void UnregisterOp(Iter iter);
 
+  void DisassembleInto(const std::string &entryPoint, std::string &ret,
+                       const std::function<bool(const std::string &)> &output,
+                       size_t chunkSize) const;
+
   ShaderVariable EvaluateConstant(Id constID, const std::vector<SpecConstant> &specInfo) const;
   rdcstr StringiseConstant(rdcspv::Id id) const;
 
@@ -0,0 +1,559 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "spirv_reflect_cache.h"
+#include "3rdparty/zstd/xxhash.h"
+#include "common/shader_cache.h"
+#include "serialise/serialiser.h"
+
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData::InterfaceAccess);
+DECLARE_REFLECTION_STRUCT(SPIRVPatchData);
+
+template <>
+rdcstr DoStringise(const SPIRVPatchData::InterfaceAccess &el)
+{
+  return "SPIRVPatchData::InterfaceAccess"_lit;
+}
+
+template <>
+rdcstr DoStringise(const SPIRVPatchData &el)
+{
+  return "SPIRVPatchData"_lit;
+}
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData::InterfaceAccess &el)
+{
+  uint32_t ID = el.ID.value();
+  uint32_t structID = el.structID.value();
+
+  SERIALISE_ELEMENT(ID);
+  SERIALISE_ELEMENT(structID);
+  SERIALISE_MEMBER(structMemberIndex);
+  SERIALISE_MEMBER(accessChain);
+  SERIALISE_MEMBER(isArraySubsequentElement);
+
+  el.ID = rdcspv::Id::fromWord(ID);
+  el.structID = rdcspv::Id::fromWord(structID);
+}
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, SPIRVPatchData &el)
+{
+  SERIALISE_MEMBER(inputs);
+  SERIALISE_MEMBER(outputs);
+  SERIALISE_MEMBER(outTopo);
+}
+
+namespace
+{
+// bump whenever reflection or disassembly output changes, so stale results are never returned.
+// Keys include it, so old entries simply stop being hit.
+static const uint32_t ReflectionCacheVersion = 1;
+
+static const uint32_t ReflectionCacheMagic = MAKE_FOURCC('S', 'P', 'R', 'C');
+static const uint32_t ReflectionCacheFileVersion = 1;
+
+// don't let the file grow without bound across many captures
+static const uint64_t MaxCacheSize = 128 * 1024 * 1024;
+
+enum class CacheEntry : uint32_t
+{
+  Module = 1,
+  Reflection,
+  Disassembly,
+};
+
+struct ReflectionCacheCallbacks
+{
+  bool Create(uint32_t size, const byte *data, bytebuf *blob) const
+  {
+    blob->assign(data, size);
+    return true;
+  }
+
+  void Destroy(const bytebuf &blob) const {}
+  uint32_t GetSize(const bytebuf &blob) const { return (uint32_t)blob.size(); }
+  const byte *GetData(const bytebuf &blob) const { return blob.data(); }
+} ReflectionCacheCallbacks;
+
+class KeyHasher
+{
+public:
+  KeyHasher(uint64_t moduleHash, CacheEntry type)
+  {
+    Add(moduleHash);
+    Add(ReflectionCacheVersion);
+    Add(type);
+  }
+
+  template <typename T>
+  void Add(const T &val)
+  {
+    data.append((const byte *)&val, sizeof(T));
+  }
+
+  void Add(const std::string &str)
+  {
+    Add((uint32_t)str.size());
+    data.append((const byte *)str.c_str(), str.size());
+  }
+
+  uint64_t Get() const { return XXH64(data.data(), data.size(), 0); }
+private:
+  bytebuf data;
+};
+};
+
+namespace rdcspv
+{
+uint64_t HashModule(const std::vector<uint32_t> &spirvWords)
+{
+  return XXH64(spirvWords.data(), spirvWords.size() * sizeof(uint32_t), 0);
+}
+
+ReflectionCache::ReflectionCache(const char *filename) : m_Filename(filename)
+{
+}
+
+ReflectionCache::~ReflectionCache()
+{
+}
+
+void ReflectionCache::LoadIfNeeded()
+{
+  if(m_Loaded)
+    return;
+
+  m_Loaded = true;
+
+  if(!LoadShaderCache(m_Filename.c_str(), ReflectionCacheMagic, ReflectionCacheFileVersion,
+                      m_Entries, ReflectionCacheCallbacks))
+  {
+    m_Entries.clear();
+    return;
+  }
+
+  for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+    m_TotalSize += it->second.size();
+}
+
+void ReflectionCache::Save()
+{
+  SCOPED_LOCK(m_Lock);
+
+  if(m_Stats.reflectionHits + m_Stats.reflectionMisses > 0)
+    RDCLOG("SPIR-V reflection cache: %u hits, %u misses. Disassembly: %u hits, %u misses",
+           m_Stats.reflectionHits, m_Stats.reflectionMisses, m_Stats.disassemblyHits,
+           m_Stats.disassemblyMisses);
+
+  if(!m_Dirty)
+    return;
+
+  SaveShaderCache(m_Filename.c_str(), ReflectionCacheMagic, ReflectionCacheFileVersion, m_Entries,
+                  ReflectionCacheCallbacks);
+
+  m_Dirty = false;
+}
+
+bool ReflectionCache::Fetch(uint64_t key, bytebuf &blob)
+{
+  SCOPED_LOCK(m_Lock);
+
+  LoadIfNeeded();
+
+  auto it = m_Entries.find(key);
+  if(it == m_Entries.end())
+    return false;
+
+  blob = it->second;
+  return true;
+}
+
+void ReflectionCache::Store(uint64_t key, const bytebuf &blob)
+{
+  SCOPED_LOCK(m_Lock);
+
+  LoadIfNeeded();
+
+  if(m_TotalSize + blob.size() > MaxCacheSize || m_Entries.find(key) != m_Entries.end())
+    return;
+
+  m_Entries[key] = blob;
+  m_TotalSize += blob.size();
+  m_Dirty = true;
+}
+
+bool ReflectionCache::ContainsModule(uint64_t moduleHash)
+{
+  bytebuf blob;
+  return Fetch(KeyHasher(moduleHash, CacheEntry::Module).Get(), blob);
+}
+
+bool ReflectionCache::FetchReflection(uint64_t moduleHash, const std::string &entryPoint,
+                                      ShaderStage stage, const std::vector<SpecConstant> &specInfo,
+                                      ShaderReflection &reflection,
+                                      ShaderBindpointMapping &mapping, SPIRVPatchData &patchData)
+{
+  KeyHasher key(moduleHash, CacheEntry::Reflection);
+  key.Add(entryPoint);
+  key.Add(stage);
+  for(const SpecConstant &spec : specInfo)
+  {
+    key.Add(spec.specID);
+    key.Add(spec.value);
+    key.Add((uint64_t)spec.dataSize);
+  }
+
+  bytebuf blob;
+  bool hit = Fetch(key.Get(), blob);
+
+  if(hit)
+  {
+    ReadSerialiser ser(new StreamReader(blob.data(), blob.size()), Ownership::Stream);
+
+    ser.ReadChunk<uint32_t>();
+    SERIALISE_ELEMENT(reflection);
+    SERIALISE_ELEMENT(mapping);
+    SERIALISE_ELEMENT(patchData);
+    ser.EndChunk();
+
+    // treat anything unreadable as a miss and regenerate it
+    hit = !ser.IsErrored();
+  }
+
+  {
+    SCOPED_LOCK(m_Lock);
+    if(hit)
+      m_Stats.reflectionHits++;
+    else
+      m_Stats.reflectionMisses++;
+  }
+
+  return hit;
+}
+
+void ReflectionCache::StoreReflection(uint64_t moduleHash, const std::string &entryPoint,
+                                      ShaderStage stage, const std::vector<SpecConstant> &specInfo,
+                                      const ShaderReflection &reflection,
+                                      const ShaderBindpointMapping &mapping,
+                                      const SPIRVPatchData &patchData)
+{
+  KeyHasher key(moduleHash, CacheEntry::Reflection);
+  key.Add(entryPoint);
+  key.Add(stage);
+  for(const SpecConstant &spec : specInfo)
+  {
+    key.Add(spec.specID);
+    key.Add(spec.value);
+    key.Add((uint64_t)spec.dataSize);
+  }
+
+  // the bytecode is already in hand whenever the cache is consulted, don't store a copy per entry
+  ShaderReflection refl = reflection;
+  refl.rawBytes.clear();
+  refl.resourceId = ResourceId();
+
+  ShaderBindpointMapping map = mapping;
+  SPIRVPatchData patch = patchData;
+
+  StreamWriter *writer = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    WriteSerialiser ser(writer, Ownership::Nothing);
+
+    SCOPED_SERIALISE_CHUNK(CacheEntry::Reflection);
+    SERIALISE_ELEMENT(refl);
+    SERIALISE_ELEMENT(map);
+    SERIALISE_ELEMENT(patch);
+  }
+
+  bytebuf blob;
+  blob.assign(writer->GetData(), (size_t)writer->GetOffset());
+  delete writer;
+
+  Store(key.Get(), blob);
+  Store(KeyHasher(moduleHash, CacheEntry::Module).Get(), bytebuf());
+}
+
+bool ReflectionCache::FetchDisassembly(uint64_t moduleHash, const std::string &entryPoint,
+                                       std::string &disasm)
+{
+  KeyHasher key(moduleHash, CacheEntry::Disassembly);
+  key.Add(entryPoint);
+
+  bytebuf blob;
+  bool hit = Fetch(key.Get(), blob);
+
+  if(hit)
+    disasm.assign((const char *)blob.data(), blob.size());
+
+  {
+    SCOPED_LOCK(m_Lock);
+    if(hit)
+      m_Stats.disassemblyHits++;
+    else
+      m_Stats.disassemblyMisses++;
+  }
+
+  return hit;
+}
+
+void ReflectionCache::StoreDisassembly(uint64_t moduleHash, const std::string &entryPoint,
+                                       const std::string &disasm)
+{
+  KeyHasher key(moduleHash, CacheEntry::Disassembly);
+  key.Add(entryPoint);
+
+  bytebuf blob;
+  blob.assign((const byte *)disasm.c_str(), disasm.size());
+
+  Store(key.Get(), blob);
+  Store(KeyHasher(moduleHash, CacheEntry::Module).Get(), bytebuf());
+}
+
+ReflectionCache::Stats ReflectionCache::GetStats()
+{
+  SCOPED_LOCK(m_Lock);
+  return m_Stats;
+}
+
+ReflectionCache &GetReflectionCache()
+{
+  static ReflectionCache cache("spirvreflection.cache");
+  return cache;
+}
+};
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
+#include "core/core.h"
+#include "spirv_compile.h"
+
+static std::vector<uint32_t> CompileCacheTestShader(uint32_t numBlocks)
+{
+  rdcspv::CompilationSettings settings;
+  settings.entryPoint = "main";
+  settings.lang = rdcspv::InputLanguage::VulkanGLSL;
+  settings.stage = rdcspv::ShaderStage::Fragment;
+
+  std::string src = "#version 450 core\n\n";
+
+  for(uint32_t i = 0; i < numBlocks; i++)
+    src += StringFormat::Fmt(
+        "layout(binding = %u) uniform block%u {\n  vec4 a%u;\n  mat4 b%u;\n  float c%u[4];\n};\n\n",
+        i, i, i, i, i);
+
+  src += "layout(location = 0) in vec4 inCol;\nlayout(location = 0) out vec4 col;\n\n";
+  src += "void main() {\n  col = inCol;\n";
+  for(uint32_t i = 0; i < numBlocks; i++)
+    src += StringFormat::Fmt("  col += a%u * b%u + c%u[%u];\n", i, i, i, i % 4);
+  src += "}\n";
+
+  std::vector<uint32_t> spirv;
+  std::string errors = rdcspv::Compile(settings, {src}, spirv);
+
+  INFO("SPIR-V compilation - " << errors);
+  REQUIRE(spirv.size() > 0);
+
+  return spirv;
+}
+
+TEST_CASE("Test SPIR-V reflection cache", "[spirv]")
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  const char *filename = "spirvreflection_test.cache";
+  FileIO::Delete(FileIO::GetAppFolderFilename(filename).c_str());
+
+  std::vector<uint32_t> spirv = CompileCacheTestShader(3);
+  uint64_t hash = rdcspv::HashModule(spirv);
+
+  rdcspv::Reflector reflector;
+  reflector.Parse(spirv);
+
+  std::vector<SpecConstant> spec;
+
+  ShaderReflection refl;
+  ShaderBindpointMapping mapping;
+  SPIRVPatchData patchData;
+  reflector.MakeReflection(GraphicsAPI::Vulkan, ShaderStage::Pixel, "main", spec, refl, mapping,
+                           patchData);
+
+  std::string disasm = reflector.Disassemble("main");
+
+  {
+    rdcspv::ReflectionCache cache(filename);
+
+    CHECK_FALSE(cache.ContainsModule(hash));
+
+    ShaderReflection cachedRefl;
+    ShaderBindpointMapping cachedMapping;
+    SPIRVPatchData cachedPatch;
+    CHECK_FALSE(cache.FetchReflection(hash, "main", ShaderStage::Pixel, spec, cachedRefl,
+                                      cachedMapping, cachedPatch));
+
+    cache.StoreReflection(hash, "main", ShaderStage::Pixel, spec, refl, mapping, patchData);
+    cache.StoreDisassembly(hash, "main", disasm);
+
+    CHECK(cache.ContainsModule(hash));
+
+    // anything differing in the key misses
+    CHECK_FALSE(cache.FetchReflection(hash, "other", ShaderStage::Pixel, spec, cachedRefl,
+                                      cachedMapping, cachedPatch));
+    CHECK_FALSE(cache.FetchReflection(hash, "main", ShaderStage::Vertex, spec, cachedRefl,
+                                      cachedMapping, cachedPatch));
+    CHECK_FALSE(cache.FetchReflection(hash, "main", ShaderStage::Pixel, {SpecConstant(0, 1, 4)},
+                                      cachedRefl, cachedMapping, cachedPatch));
+    CHECK_FALSE(cache.FetchReflection(hash + 1, "main", ShaderStage::Pixel, spec, cachedRefl,
+                                      cachedMapping, cachedPatch));
+
+    rdcspv::ReflectionCache::Stats stats = cache.GetStats();
+    CHECK(stats.reflectionHits == 0);
+    CHECK(stats.reflectionMisses == 5);
+
+    cache.Save();
+  }
+
+  // a new cache picks the results up from disk
+  {
+    rdcspv::ReflectionCache cache(filename);
+
+    ShaderReflection cachedRefl;
+    ShaderBindpointMapping cachedMapping;
+    SPIRVPatchData cachedPatch;
+    REQUIRE(cache.FetchReflection(hash, "main", ShaderStage::Pixel, spec, cachedRefl,
+                                  cachedMapping, cachedPatch));
+
+    CHECK(cachedRefl.entryPoint == refl.entryPoint);
+    CHECK(cachedRefl.stage == refl.stage);
+    CHECK(cachedRefl.rawBytes.empty());
+    CHECK(cachedRefl.inputSignature.size() == refl.inputSignature.size());
+    CHECK(cachedRefl.outputSignature.size() == refl.outputSignature.size());
+    REQUIRE(cachedRefl.constantBlocks.size() == 3);
+    for(size_t i = 0; i < 3; i++)
+    {
+      CHECK(cachedRefl.constantBlocks[i].name == refl.constantBlocks[i].name);
+      CHECK(cachedRefl.constantBlocks[i].byteSize == refl.constantBlocks[i].byteSize);
+      CHECK(cachedRefl.constantBlocks[i].variables.size() ==
+            refl.constantBlocks[i].variables.size());
+    }
+
+    bool sameBlocks = (cachedMapping.constantBlocks == mapping.constantBlocks);
+    bool sameAttributes = (cachedMapping.inputAttributes == mapping.inputAttributes);
+    CHECK(sameBlocks);
+    CHECK(sameAttributes);
+
+    REQUIRE(cachedPatch.inputs.size() == patchData.inputs.size());
+    REQUIRE(cachedPatch.outputs.size() == patchData.outputs.size());
+    for(size_t i = 0; i < patchData.outputs.size(); i++)
+    {
+      CHECK(cachedPatch.outputs[i].ID == patchData.outputs[i].ID);
+      CHECK(cachedPatch.outputs[i].accessChain == patchData.outputs[i].accessChain);
+    }
+    CHECK(cachedPatch.outTopo == patchData.outTopo);
+
+    std::string cachedDisasm;
+    REQUIRE(cache.FetchDisassembly(hash, "main", cachedDisasm));
+    CHECK(cachedDisasm == disasm);
+
+    rdcspv::ReflectionCache::Stats stats = cache.GetStats();
+    CHECK(stats.reflectionHits == 1);
+    CHECK(stats.disassemblyHits == 1);
+  }
+
+  FileIO::Delete(FileIO::GetAppFolderFilename(filename).c_str());
+};
+
+TEST_CASE("Benchmark SPIR-V reflection cache load", "[.][benchmark][spirv]")
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  const char *filename = "spirvreflection_bench.cache";
+  FileIO::Delete(FileIO::GetAppFolderFilename(filename).c_str());
+
+  // a corpus of distinct modules of varying complexity
+  std::vector<std::vector<uint32_t>> corpus;
+  for(uint32_t i = 0; i < 200; i++)
+    corpus.push_back(CompileCacheTestShader(1 + (i % 40)));
+
+  std::vector<SpecConstant> spec;
+
+  auto load = [&corpus, &spec](rdcspv::ReflectionCache &cache) {
+    for(const std::vector<uint32_t> &spirv : corpus)
+    {
+      uint64_t hash = rdcspv::HashModule(spirv);
+
+      ShaderReflection refl;
+      ShaderBindpointMapping mapping;
+      SPIRVPatchData patchData;
+      if(!cache.FetchReflection(hash, "main", ShaderStage::Pixel, spec, refl, mapping, patchData))
+      {
+        rdcspv::Reflector reflector;
+        reflector.Parse(spirv);
+        reflector.MakeReflection(GraphicsAPI::Vulkan, ShaderStage::Pixel, "main", spec, refl,
+                                 mapping, patchData);
+        cache.StoreReflection(hash, "main", ShaderStage::Pixel, spec, refl, mapping, patchData);
+      }
+    }
+  };
+
+  double coldTime, warmTime;
+
+  {
+    rdcspv::ReflectionCache cache(filename);
+
+    PerformanceTimer timer;
+    load(cache);
+    coldTime = timer.GetMilliseconds();
+
+    cache.Save();
+  }
+
+  rdcspv::ReflectionCache::Stats stats;
+
+  {
+    rdcspv::ReflectionCache cache(filename);
+
+    PerformanceTimer timer;
+    load(cache);
+    warmTime = timer.GetMilliseconds();
+
+    stats = cache.GetStats();
+  }
+
+  WARN("Reflecting " << corpus.size() << " modules: " << coldTime << "ms uncached, " << warmTime
+                     << "ms from the cache. Hit rate " << stats.reflectionHits << "/"
+                     << (stats.reflectionHits + stats.reflectionMisses));
+
+  CHECK(stats.reflectionHits == corpus.size());
+
+  FileIO::Delete(FileIO::GetAppFolderFilename(filename).c_str());
+};
+
+#endif
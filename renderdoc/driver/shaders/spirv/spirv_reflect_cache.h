@@ -0,0 +1,92 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <map>
+#include "common/threading.h"
+#include "spirv_reflect.h"
+
+namespace rdcspv
+{
+// hash identifying a module's contents, used as the base of all cache keys for that module
+uint64_t HashModule(const std::vector<uint32_t> &spirvWords);
+
+// persistent cache of reflection and disassembly results, keyed by module contents so that the
+// same shader seen in a later capture doesn't need to be parsed and reflected again. Safe to use
+// from multiple threads.
+class ReflectionCache
+{
+public:
+  ReflectionCache(const char *filename);
+  ~ReflectionCache();
+
+  // writes the cache back to disk if anything was added since it was loaded
+  void Save();
+
+  // true if any results are cached for this module, in which case parsing can be deferred until
+  // something misses
+  bool ContainsModule(uint64_t moduleHash);
+
+  // the reflection's rawBytes and resourceId are not stored and must be filled in by the caller
+  bool FetchReflection(uint64_t moduleHash, const std::string &entryPoint, ShaderStage stage,
+                       const std::vector<SpecConstant> &specInfo, ShaderReflection &reflection,
+                       ShaderBindpointMapping &mapping, SPIRVPatchData &patchData);
+  void StoreReflection(uint64_t moduleHash, const std::string &entryPoint, ShaderStage stage,
+                       const std::vector<SpecConstant> &specInfo,
+                       const ShaderReflection &reflection, const ShaderBindpointMapping &mapping,
+                       const SPIRVPatchData &patchData);
+
+  bool FetchDisassembly(uint64_t moduleHash, const std::string &entryPoint, std::string &disasm);
+  void StoreDisassembly(uint64_t moduleHash, const std::string &entryPoint,
+                        const std::string &disasm);
+
+  struct Stats
+  {
+    uint32_t reflectionHits = 0;
+    uint32_t reflectionMisses = 0;
+    uint32_t disassemblyHits = 0;
+    uint32_t disassemblyMisses = 0;
+  };
+
+  Stats GetStats();
+
+private:
+  void LoadIfNeeded();
+  bool Fetch(uint64_t key, bytebuf &blob);
+  void Store(uint64_t key, const bytebuf &blob);
+
+  std::string m_Filename;
+  bool m_Loaded = false;
+  bool m_Dirty = false;
+  uint64_t m_TotalSize = 0;
+
+  Threading::CriticalSection m_Lock;
+  std::map<uint64_t, bytebuf> m_Entries;
+  Stats m_Stats;
+};
+
+// the cache shared by every capture opened in this process
+ReflectionCache &GetReflectionCache();
+};
@@ -35,11 +35,11 @@ struct feedbackData
   uint32_t numEntries;
 };
 
-void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
-                    const std::map<rdcspv::Binding, feedbackData> &offsetMap, VkDeviceAddress addr,
-                    std::vector<uint32_t> &modSpirv)
+void AnnotateShader(const rdcspv::Processor &parsed, const SPIRVPatchData &patchData,
+                    const char *entryName, const std::map<rdcspv::Binding, feedbackData> &offsetMap,
+                    VkDeviceAddress addr, std::vector<uint32_t> &modSpirv)
 {
-  rdcspv::Editor editor(modSpirv);
+  rdcspv::Editor editor(modSpirv, parsed);
 
   editor.Prepare();
 
@@ -309,10 +309,7 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
 
     // we're past the existing function parameters, now declare our new ones
     for(size_t i = 0; i < patchedParamIDs.size(); i++)
-    {
       editor.AddOperation(it, rdcspv::OpFunctionParameter(funcParamType, patchedParamIDs[i]));
-      ++it;
-    }
 
     // now patch accesses in the function body
     for(; it; ++it)
@@ -364,14 +361,13 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
           for(size_t i = 1; i < it.size(); i++)
             funccall.insert(funccall.begin() + i - 1, it.word(i));
 
-          rdcspv::Iter oldCall = it;
-
           // add our patched call afterwards
-          it++;
-          editor.AddOperation(it, rdcspv::Operation(rdcspv::Op::FunctionCall, funccall));
+          rdcspv::Iter nextOp = it;
+          nextOp++;
+          editor.AddOperation(nextOp, rdcspv::Operation(rdcspv::Op::FunctionCall, funccall));
 
           // remove the old call
-          editor.Remove(oldCall);
+          editor.Remove(it);
         }
 
         // if this function isn't marked for patching yet, and isn't patched, queue it
@@ -398,8 +394,10 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
 
           rdcspv::Id index = chain.indexes[0];
 
-          // patch after the access chain
-          it++;
+          // patch after the access chain. Added operations are buffered so it keeps pointing at
+          // the access chain and the loop continues with the next original operation
+          rdcspv::Iter patchIt = it;
+          patchIt++;
 
           // upcast the index to uint32 or uint64 depending on which path we're taking
           uint32_t targetIndexWidth = useBufferAddress ? 64 : 32;
@@ -430,9 +428,8 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
               indexTypeData.signedness = false;
 
               rdcspv::Id unsignedIndex = editor.MakeId();
-              editor.AddOperation(
-                  it, rdcspv::OpBitcast(editor.DeclareType(indexTypeData), unsignedIndex, index));
-              it++;
+              editor.AddOperation(patchIt, rdcspv::OpBitcast(editor.DeclareType(indexTypeData),
+                                                             unsignedIndex, index));
 
               index = unsignedIndex;
             }
@@ -443,8 +440,8 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
               rdcspv::Id extendedtype =
                   editor.DeclareType(rdcspv::Scalar(rdcspv::Op::TypeInt, targetIndexWidth, false));
               rdcspv::Id extendedindex = editor.MakeId();
-              editor.AddOperation(it, rdcspv::OpUConvert(extendedtype, extendedindex, index));
-              it++;
+              editor.AddOperation(patchIt,
+                                  rdcspv::OpUConvert(extendedtype, extendedindex, index));
 
               index = extendedindex;
             }
@@ -460,27 +457,25 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
             // baseaddr = bufferAddressConst + bindingOffset
             rdcspv::Id baseaddr = editor.MakeId();
             editor.AddOperation(
-                it, rdcspv::OpIAdd(uint64ID, baseaddr, bufferAddressConst, varIt->second));
-            it++;
+                patchIt, rdcspv::OpIAdd(uint64ID, baseaddr, bufferAddressConst, varIt->second));
 
             // shift the index since this is a byte offset
             // shiftedindex = index << uint32shift
             rdcspv::Id shiftedindex = editor.MakeId();
             editor.AddOperation(
-                it, rdcspv::OpShiftLeftLogical(uint64ID, shiftedindex, index, uint32shift));
-            it++;
+                patchIt, rdcspv::OpShiftLeftLogical(uint64ID, shiftedindex, index, uint32shift));
 
             // add the index on top of that
             // offsetaddr = baseaddr + shiftedindex
             rdcspv::Id offsetaddr = editor.MakeId();
-            editor.AddOperation(it, rdcspv::OpIAdd(uint64ID, offsetaddr, baseaddr, shiftedindex));
-            it++;
+            editor.AddOperation(patchIt,
+                                rdcspv::OpIAdd(uint64ID, offsetaddr, baseaddr, shiftedindex));
 
             // make a pointer out of it
             // uint32_t *bufptr = (uint32_t *)offsetaddr
             bufptr = editor.MakeId();
-            editor.AddOperation(it, rdcspv::OpConvertUToPtr(uint32ptrtype, bufptr, offsetaddr));
-            it++;
+            editor.AddOperation(patchIt,
+                                rdcspv::OpConvertUToPtr(uint32ptrtype, bufptr, offsetaddr));
           }
           else
           {
@@ -489,23 +484,20 @@ void AnnotateShader(const SPIRVPatchData &patchData, const char *entryName,
             // add the index to this binding's base index
             // ssboindex = bindingOffset + index
             rdcspv::Id ssboindex = editor.MakeId();
-            editor.AddOperation(it, rdcspv::OpIAdd(uint32ID, ssboindex, index, varIt->second));
-            it++;
+            editor.AddOperation(patchIt,
+                                rdcspv::OpIAdd(uint32ID, ssboindex, index, varIt->second));
 
             // accesschain to get the pointer we'll atomic into.
             // accesschain is 0 to access rtarray (first member) then ssboindex for array index
             // uint32_t *bufptr = (uint32_t *)&buf.rtarray[ssboindex];
             bufptr = editor.MakeId();
-            editor.AddOperation(it, rdcspv::OpAccessChain(uint32ptrtype, bufptr, ssboVar,
-                                                          {rtarrayOffset, ssboindex}));
-            it++;
+            editor.AddOperation(patchIt, rdcspv::OpAccessChain(uint32ptrtype, bufptr, ssboVar,
+                                                               {rtarrayOffset, ssboindex}));
           }
 
           // atomically set the uint32 that's pointed to
-          editor.AddOperation(it, rdcspv::OpAtomicUMax(uint32ID, editor.MakeId(), bufptr, scope,
-                                                       semantics, usedValue));
-
-          // no it++ here, it will happen implicitly on loop continue
+          editor.AddOperation(patchIt, rdcspv::OpAtomicUMax(uint32ID, editor.MakeId(), bufptr,
+                                                            scope, semantics, usedValue));
         }
       }
     }
@@ -702,9 +694,10 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
     const VulkanCreationInfo::ShaderModule &moduleInfo =
         creationInfo.m_ShaderModule[pipeInfo.shaders[5].module];
 
-    std::vector<uint32_t> modSpirv = moduleInfo.spirv.GetSPIRV();
+    std::vector<uint32_t> modSpirv;
 
-    AnnotateShader(*pipeInfo.shaders[5].patchData, stage.pName, offsetMap, bufferAddress, modSpirv);
+    AnnotateShader(moduleInfo.GetReflector(), *pipeInfo.shaders[5].GetPatchData(), stage.pName,
+                   offsetMap, bufferAddress, modSpirv);
 
     moduleCreateInfo.pCode = modSpirv.data();
     moduleCreateInfo.codeSize = modSpirv.size() * sizeof(uint32_t);
@@ -726,10 +719,10 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
       const VulkanCreationInfo::ShaderModule &moduleInfo =
           creationInfo.m_ShaderModule[pipeInfo.shaders[idx].module];
 
-      std::vector<uint32_t> modSpirv = moduleInfo.spirv.GetSPIRV();
+      std::vector<uint32_t> modSpirv;
 
-      AnnotateShader(*pipeInfo.shaders[idx].patchData, stage.pName, offsetMap, bufferAddress,
-                     modSpirv);
+      AnnotateShader(moduleInfo.GetReflector(), *pipeInfo.shaders[idx].GetPatchData(), stage.pName,
+                     offsetMap, bufferAddress, modSpirv);
 
       moduleCreateInfo.pCode = modSpirv.data();
       moduleCreateInfo.codeSize = modSpirv.size() * sizeof(uint32_t);
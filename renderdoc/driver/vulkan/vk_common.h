@@ -1254,6 +1254,15 @@ DECLARE_REFLECTION_STRUCT(VkVertexInputBindingDivisorDescriptionEXT);
 DECLARE_REFLECTION_STRUCT(VkViewport);
 DECLARE_REFLECTION_STRUCT(VkXYColorEXT);
 
+DECLARE_BULK_SERIALISABLE(VkDrawIndexedIndirectCommand);
+DECLARE_BULK_SERIALISABLE(VkDrawIndirectCommand);
+DECLARE_BULK_SERIALISABLE(VkExtent2D);
+DECLARE_BULK_SERIALISABLE(VkExtent3D);
+DECLARE_BULK_SERIALISABLE(VkOffset2D);
+DECLARE_BULK_SERIALISABLE(VkOffset3D);
+DECLARE_BULK_SERIALISABLE(VkRect2D);
+DECLARE_BULK_SERIALISABLE(VkViewport);
+
 DECLARE_DESERIALISE_TYPE(VkDescriptorSetLayoutBinding);
 DECLARE_DESERIALISE_TYPE(VkPresentRegionKHR);
 DECLARE_DESERIALISE_TYPE(VkSparseBufferMemoryBindInfo);
@@ -536,6 +536,7 @@ WriteSerialiser &WrappedVulkan::GetThreadSerialiser()
 
   ser->SetChunkMetadataRecording(flags);
   ser->SetUserData(GetResourceManager());
+  ser->SetChunkLookup(&GetChunkName);
   ser->SetVersion(VkInitParams::CurrentVersion);
 
   Threading::SetTLSValue(threadSerialiserTLSSlot, (void *)ser);
@@ -3778,7 +3779,10 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
     const std::vector<BakedCmdBufferInfo::CmdBufferState::DescriptorAndOffsets> &descSets =
         (shad == 5 ? state.computeDescSets : state.graphicsDescSets);
 
-    RDCASSERT(sh.mapping);
+    ShaderBindpointMapping *mapping = sh.GetMapping();
+    const ShaderReflection *refl = sh.GetReflection();
+
+    RDCASSERT(mapping);
 
     struct ResUsageType
     {
@@ -3788,9 +3792,9 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
     };
 
     ResUsageType types[] = {
-        ResUsageType(sh.mapping->readOnlyResources, ResourceUsage::VS_Resource),
-        ResUsageType(sh.mapping->readWriteResources, ResourceUsage::VS_RWResource),
-        ResUsageType(sh.mapping->constantBlocks, ResourceUsage::VS_Constants),
+        ResUsageType(mapping->readOnlyResources, ResourceUsage::VS_Resource),
+        ResUsageType(mapping->readWriteResources, ResourceUsage::VS_RWResource),
+        ResUsageType(mapping->constantBlocks, ResourceUsage::VS_Constants),
     };
 
     DebugMessage msg;
@@ -3808,7 +3812,7 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
           continue;
 
         // ignore push constants
-        if(t == 2 && !sh.refl->constantBlocks[i].bufferBacked)
+        if(t == 2 && !refl->constantBlocks[i].bufferBacked)
           continue;
 
         int32_t bindset = types[t].bindmap[i].bindset;
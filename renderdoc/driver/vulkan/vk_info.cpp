@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "vk_info.h"
+#include "driver/shaders/spirv/spirv_reflect_cache.h"
 
 VkDynamicState ConvertDynamicState(VulkanDynamicStateIndex idx)
 {
@@ -255,12 +256,10 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan,
 
     ShaderModuleReflection &reflData = info.m_ShaderModule[shadid].m_Reflections[key];
 
-    reflData.Init(resourceMan, shadid, info.m_ShaderModule[shadid].spirv, shad.entryPoint,
-                  pCreateInfo->pStages[i].stage, shad.specialization);
+    reflData.Init(resourceMan, shadid, info.m_ShaderModule[shadid], shad.entryPoint, pCreateInfo->pStages[i].stage,
+                  shad.specialization);
 
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
-    shad.patchData = &reflData.patchData;
+    shad.reflData = &reflData;
   }
 
   if(pCreateInfo->pVertexInputState)
@@ -586,12 +585,10 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModuleReflection &reflData = info.m_ShaderModule[shadid].m_Reflections[key];
 
-    reflData.Init(resourceMan, shadid, info.m_ShaderModule[shadid].spirv, shad.entryPoint,
-                  pCreateInfo->stage.stage, shad.specialization);
+    reflData.Init(resourceMan, shadid, info.m_ShaderModule[shadid], shad.entryPoint, pCreateInfo->stage.stage,
+                  shad.specialization);
 
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
-    shad.patchData = &reflData.patchData;
+    shad.reflData = &reflData;
   }
 
   topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -1043,6 +1040,14 @@ void VulkanCreationInfo::ImageView::Init(VulkanResourceManager *resourceMan, Vul
   swizzle[3] = Convert(pCreateInfo->components.a, 3);
 }
 
+VulkanCreationInfo::ShaderModule::~ShaderModule()
+{
+  // background jobs reference the module, so they must finish before it goes away
+  for(auto it = m_Reflections.begin(); it != m_Reflections.end(); ++it)
+    it->second.Wait();
+  parsed.Wait();
+}
+
 void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
                                             VulkanCreationInfo &info,
                                             const VkShaderModuleCreateInfo *pCreateInfo)
@@ -1055,14 +1060,41 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   else
   {
     RDCASSERT(pCreateInfo->codeSize % sizeof(uint32_t) == 0);
-    spirv.Parse(std::vector<uint32_t>(
-        (uint32_t *)(pCreateInfo->pCode),
-        (uint32_t *)(pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t))));
+
+    words.assign((uint32_t *)(pCreateInfo->pCode),
+                 (uint32_t *)(pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t)));
+    hash = rdcspv::HashModule(words);
+
+    ShaderModule *mod = this;
+    std::function<void()> parse = [mod]() { mod->spirv.Parse(mod->words); };
+
+    // a module seen in a previous capture will most likely have all its reflection cached, so
+    // only parse it if something actually needs it
+    if(rdcspv::GetReflectionCache().ContainsModule(hash))
+      parsed = Threading::MakeDeferred(parse);
+    else
+      parsed = Threading::RunAsync(parse);
   }
 }
 
+std::string VulkanCreationInfo::ShaderModule::Disassemble(const std::string &entry) const
+{
+  rdcspv::ReflectionCache &cache = rdcspv::GetReflectionCache();
+
+  std::string ret;
+  if(!words.empty() && cache.FetchDisassembly(hash, entry, ret))
+    return ret;
+
+  ret = GetReflector().Disassemble(entry);
+
+  if(!words.empty())
+    cache.StoreDisassembly(hash, entry, ret);
+
+  return ret;
+}
+
 void VulkanCreationInfo::ShaderModuleReflection::Init(VulkanResourceManager *resourceMan,
-                                                      ResourceId id, const rdcspv::Reflector &spv,
+                                                      ResourceId id, const ShaderModule &module,
                                                       const std::string &entry,
                                                       VkShaderStageFlagBits stage,
                                                       const std::vector<SpecConstant> &specInfo)
@@ -1072,10 +1104,33 @@ void VulkanCreationInfo::ShaderModuleReflection::Init(VulkanResourceManager *res
     entryPoint = entry;
     stageIndex = StageIndex(stage);
 
-    spv.MakeReflection(GraphicsAPI::Vulkan, ShaderStage(stageIndex), entryPoint, specInfo, refl,
-                       mapping, patchData);
+    // the resource manager isn't safe to use from the background, look the ID up now
+    ResourceId origId = resourceMan->GetOriginalID(id);
+
+    // Reflector is const once parsed, so several entry points of one module can reflect at once
+    const ShaderModule *mod = &module;
+    reflected = Threading::RunAsync([this, mod, specInfo, origId]() {
+      rdcspv::ReflectionCache &cache = rdcspv::GetReflectionCache();
+      ShaderStage shaderStage = ShaderStage(stageIndex);
+
+      if(!mod->words.empty() && cache.FetchReflection(mod->hash, entryPoint, shaderStage, specInfo,
+                                                      refl, mapping, patchData))
+      {
+        refl.rawBytes.assign((const byte *)mod->words.data(),
+                             mod->words.size() * sizeof(uint32_t));
+      }
+      else
+      {
+        mod->GetReflector().MakeReflection(GraphicsAPI::Vulkan, shaderStage, entryPoint, specInfo,
+                                           refl, mapping, patchData);
+
+        if(!mod->words.empty())
+          cache.StoreReflection(mod->hash, entryPoint, shaderStage, specInfo, refl, mapping,
+                                patchData);
+      }
 
-    refl.resourceId = resourceMan->GetOriginalID(id);
+      refl.resourceId = origId;
+    });
   }
 }
 
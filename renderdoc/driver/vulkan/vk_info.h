@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "common/threading.h"
 #include "driver/shaders/spirv/spirv_reflect.h"
 #include "vk_common.h"
 #include "vk_manager.h"
@@ -152,6 +153,8 @@ struct VulkanCreationInfo
     ResourceId specialisingPipe;
   };
 
+  struct ShaderModule;
+
   struct ShaderModuleReflection
   {
     uint32_t stageIndex;
@@ -161,9 +164,19 @@ struct VulkanCreationInfo
     ShaderBindpointMapping mapping;
     SPIRVPatchData patchData;
 
-    void Init(VulkanResourceManager *resourceMan, ResourceId id, const rdcspv::Reflector &spv,
+    // reflection runs in the background once the module has been parsed. entryPoint and
+    // stageIndex are valid immediately, the rest only after Wait()
+    void Init(VulkanResourceManager *resourceMan, ResourceId id, const ShaderModule &module,
               const std::string &entry, VkShaderStageFlagBits stage,
               const std::vector<SpecConstant> &specInfo);
+    ShaderModuleReflection &Wait()
+    {
+      reflected.Wait();
+      return *this;
+    }
+
+  private:
+    Threading::Task reflected;
   };
 
   struct Pipeline
@@ -187,12 +200,21 @@ struct VulkanCreationInfo
     // VkPipelineShaderStageCreateInfo
     struct Shader
     {
-      Shader() : refl(NULL), mapping(NULL), patchData(NULL) {}
       ResourceId module;
       std::string entryPoint;
-      ShaderReflection *refl;
-      ShaderBindpointMapping *mapping;
-      SPIRVPatchData *patchData;
+
+      // these wait for the module's reflection to be ready, and return NULL for unused stages
+      ShaderReflection *GetReflection() const { return reflData ? &reflData->Wait().refl : NULL; }
+      ShaderBindpointMapping *GetMapping() const
+      {
+        return reflData ? &reflData->Wait().mapping : NULL;
+      }
+      SPIRVPatchData *GetPatchData() const
+      {
+        return reflData ? &reflData->Wait().patchData : NULL;
+      }
+
+      ShaderModuleReflection *reflData = NULL;
 
       std::vector<SpecConstant> specialization;
     };
@@ -498,6 +520,13 @@ struct VulkanCreationInfo
 
   struct ShaderModule
   {
+    ShaderModule() = default;
+    ShaderModule(const ShaderModule &) = delete;
+    ShaderModule &operator=(const ShaderModule &) = delete;
+    ~ShaderModule();
+
+    // the SPIR-V is parsed in the background, so that loading a capture with many shaders can
+    // carry on reading chunks while modules are parsed and pipelines reflected in parallel.
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
               const VkShaderModuleCreateInfo *pCreateInfo);
 
@@ -506,17 +535,34 @@ struct VulkanCreationInfo
       // look for one from this pipeline specifically, if it was specialised
       auto it = m_Reflections.find({entry, pipe});
       if(it != m_Reflections.end())
-        return it->second;
+        return it->second.Wait();
 
       // if not, just return the non-specialised version
-      return m_Reflections[{entry, ResourceId()}];
+      return m_Reflections[{entry, ResourceId()}].Wait();
     }
 
-    rdcspv::Reflector spirv;
+    // waits for the module to finish parsing
+    const rdcspv::Reflector &GetReflector() const
+    {
+      parsed.Wait();
+      return spirv;
+    }
+
+    // fetches the disassembly from the reflection cache if possible, otherwise generates it
+    std::string Disassemble(const std::string &entry) const;
 
     std::string unstrippedPath;
 
     std::map<ShaderModuleReflectionKey, ShaderModuleReflection> m_Reflections;
+
+  private:
+    friend struct ShaderModuleReflection;
+
+    std::vector<uint32_t> words;
+    uint64_t hash = 0;
+
+    rdcspv::Reflector spirv;
+    Threading::Task parsed;
   };
   std::map<ResourceId, ShaderModule> m_ShaderModule;
 
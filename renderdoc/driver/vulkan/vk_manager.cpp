@@ -915,6 +915,30 @@ bool VulkanResourceManager::Prepare_InitialState(WrappedVkRes *res)
   return m_Core->Prepare_InitialState(res);
 }
 
+bool VulkanResourceManager::IsInitialStateCacheable(WrappedVkRes *res)
+{
+  // only images have their writes fully tracked through submissions. Descriptor sets are cheap to
+  // prepare, and memory can be written from the CPU through maps at any time. Note that writes
+  // through other resources aliasing the same memory are not detected, which is part of why the
+  // cache is opt-in.
+  if(IdentifyTypeByPtr(res) != eResImage)
+    return false;
+
+  VkResourceRecord *record = ((WrappedVkImage *)res)->record;
+
+  return record && record->resInfo && !record->resInfo->untrackedWrites;
+}
+
+void VulkanResourceManager::Reuse_InitialState(WrappedVkRes *res)
+{
+  // mirror the bookkeeping in WrappedVulkan::Prepare_InitialState without reading back contents
+  WrappedVkImage *im = (WrappedVkImage *)res;
+  ResourceId id = GetID(res);
+
+  if(!FindImgRefs(id))
+    AddImageFrameRefs(id, im->record->resInfo->imageInfo);
+}
+
 uint64_t VulkanResourceManager::GetSize_InitialState(ResourceId id, const VkInitialContents &initial)
 {
   return m_Core->GetSize_InitialState(id, initial);
@@ -462,6 +462,8 @@ private:
   bool ResourceTypeRelease(WrappedVkRes *res);
 
   bool Prepare_InitialState(WrappedVkRes *res);
+  bool IsInitialStateCacheable(WrappedVkRes *res);
+  void Reuse_InitialState(WrappedVkRes *res);
   uint64_t GetSize_InitialState(ResourceId id, const VkInitialContents &initial);
   bool Serialise_InitialState(WriteSerialiser &ser, ResourceId id, VkResourceRecord *record,
                               const VkInitialContents *initial);
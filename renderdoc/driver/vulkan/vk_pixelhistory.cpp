@@ -279,10 +279,10 @@ struct VulkanPixelHistoryCallback : public VulkanDrawcallCallback
   }
 
   // Returns true if the shader was modified.
-  bool StripSideEffects(const SPIRVPatchData &patchData, const char *entryName,
-                        std::vector<uint32_t> &modSpirv)
+  bool StripSideEffects(const rdcspv::Processor &parsed, const SPIRVPatchData &patchData,
+                        const char *entryName, std::vector<uint32_t> &modSpirv)
   {
-    rdcspv::Editor editor(modSpirv);
+    rdcspv::Editor editor(modSpirv, parsed);
 
     editor.Prepare();
 
@@ -479,8 +479,9 @@ struct VulkanPixelHistoryCallback : public VulkanDrawcallCallback
     // Check if we processed this shader before.
     if(it != m_ShaderCache.end())
       return it->second;
-    std::vector<uint32_t> modSpirv = moduleInfo.spirv.GetSPIRV();
-    bool modified = StripSideEffects(*shader.patchData, shader.entryPoint.c_str(), modSpirv);
+    std::vector<uint32_t> modSpirv;
+    bool modified = StripSideEffects(moduleInfo.GetReflector(), *shader.GetPatchData(),
+                                     shader.entryPoint.c_str(), modSpirv);
     // In some cases a shader might just be binding a RW resource but not writing to it.
     // If there are no writes (shader was not modified), no need to replace the shader,
     // just insert VK_NULL_HANDLE to indicate that this shader has been processed.
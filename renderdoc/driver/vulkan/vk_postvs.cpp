@@ -48,13 +48,15 @@ static const uint32_t MeshOutputTBufferArraySize = 16;
 // 4 = sint vbuffers
 static const uint32_t MeshOutputReservedBindings = 5;
 
-static void ConvertToMeshOutputCompute(const ShaderReflection &refl, const SPIRVPatchData &patchData,
-                                       const char *entryName, std::vector<uint32_t> instDivisor,
+static void ConvertToMeshOutputCompute(const rdcspv::Processor &parsed,
+                                       const ShaderReflection &refl,
+                                       const SPIRVPatchData &patchData, const char *entryName,
+                                       std::vector<uint32_t> instDivisor,
                                        const DrawcallDescription *draw, uint32_t numVerts,
                                        uint32_t numViews, std::vector<uint32_t> &modSpirv,
                                        uint32_t &bufStride)
 {
-  rdcspv::Editor editor(modSpirv);
+  rdcspv::Editor editor(modSpirv, parsed);
 
   editor.Prepare();
 
@@ -1496,7 +1498,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   const VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
 
-  ShaderReflection *refl = pipeInfo.shaders[0].refl;
+  ShaderReflection *refl = pipeInfo.shaders[0].GetReflection();
 
   // set defaults so that we don't try to fetch this output again if something goes wrong and the
   // same event is selected again
@@ -1886,7 +1888,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   }
 
   uint32_t bufStride = 0;
-  std::vector<uint32_t> modSpirv = moduleInfo.spirv.GetSPIRV();
+  std::vector<uint32_t> modSpirv;
 
   struct CompactedAttrBuffer
   {
@@ -2254,7 +2256,8 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     m_pDriver->vkUpdateDescriptorSets(dev, numWrites, descWrites, 0, NULL);
   }
 
-  ConvertToMeshOutputCompute(*refl, *pipeInfo.shaders[0].patchData,
+  ConvertToMeshOutputCompute(moduleInfo.GetReflector(), *refl,
+                             *pipeInfo.shaders[0].GetPatchData(),
                              pipeInfo.shaders[0].entryPoint.c_str(), attrInstDivisor, drawcall,
                              numVerts, numViews, modSpirv, bufStride);
 
@@ -2654,21 +2657,21 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   int stageIndex = 3;
 
   // if there is no such shader bound, try tessellation
-  if(!pipeInfo.shaders[stageIndex].refl)
+  if(!pipeInfo.shaders[stageIndex].GetReflection())
     stageIndex = 2;
 
   // if still nothing, do vertex
-  if(!pipeInfo.shaders[stageIndex].refl)
+  if(!pipeInfo.shaders[stageIndex].GetReflection())
     stageIndex = 0;
 
-  ShaderReflection *lastRefl = pipeInfo.shaders[stageIndex].refl;
+  ShaderReflection *lastRefl = pipeInfo.shaders[stageIndex].GetReflection();
 
   RDCASSERT(lastRefl);
 
   uint32_t primitiveMultiplier = 1;
 
   // transform feedback expands strips to lists
-  switch(pipeInfo.shaders[stageIndex].patchData->outTopo)
+  switch(pipeInfo.shaders[stageIndex].GetPatchData()->outTopo)
   {
     case Topology::PointList:
       m_PostVS.Data[eventId].gsout.topo = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
@@ -2680,7 +2683,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
       break;
     default:
       RDCERR("Unexpected output topology %s",
-             ToStr(pipeInfo.shaders[stageIndex].patchData->outTopo).c_str());
+             ToStr(pipeInfo.shaders[stageIndex].GetPatchData()->outTopo).c_str());
     // deliberate fallthrough
     case Topology::TriangleList:
     case Topology::TriangleStrip:
@@ -2717,12 +2720,12 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   const VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[stageIndex].module];
 
-  std::vector<uint32_t> modSpirv = moduleInfo.spirv.GetSPIRV();
+  std::vector<uint32_t> modSpirv = moduleInfo.GetReflector().GetSPIRV();
 
   uint32_t xfbStride = 0;
 
   // adds XFB annotations in order of the output signature (with the position first)
-  AddXFBAnnotations(*lastRefl, *pipeInfo.shaders[stageIndex].patchData,
+  AddXFBAnnotations(*lastRefl, *pipeInfo.shaders[stageIndex].GetPatchData(),
                     pipeInfo.shaders[stageIndex].entryPoint.c_str(), modSpirv, xfbStride);
 
   // create vertex shader with modified code
@@ -414,12 +414,12 @@ rdcarray<ShaderEntryPoint> VulkanReplay::GetShaderEntryPoints(ResourceId shader)
   if(shad == m_pDriver->m_CreationInfo.m_ShaderModule.end())
     return {};
 
-  std::vector<std::string> entries = shad->second.spirv.EntryPoints();
+  std::vector<std::string> entries = shad->second.GetReflector().EntryPoints();
 
   rdcarray<ShaderEntryPoint> ret;
 
   for(const std::string &e : entries)
-    ret.push_back({e, shad->second.spirv.StageForEntry(e)});
+    ret.push_back({e, shad->second.GetReflector().StageForEntry(e)});
 
   return ret;
 }
@@ -438,7 +438,7 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId pipeline, ResourceId shader
   // if this shader was never used in a pipeline the reflection won't be prepared. Do that now -
   // this will be ignored if it was already prepared.
   shad->second.GetReflection(entry.name, pipeline)
-      .Init(GetResourceManager(), shader, shad->second.spirv, entry.name,
+      .Init(GetResourceManager(), shader, shad->second, entry.name,
             VkShaderStageFlagBits(1 << uint32_t(entry.stage)), {});
 
   return &shad->second.GetReflection(entry.name, pipeline).refl;
@@ -550,7 +550,7 @@ std::string VulkanReplay::DisassembleShader(ResourceId pipeline, const ShaderRef
     std::string &disasm = it->second.GetReflection(refl->entryPoint, pipeline).disassembly;
 
     if(disasm.empty())
-      disasm = it->second.spirv.Disassemble(refl->entryPoint.c_str());
+      disasm = it->second.Disassemble(refl->entryPoint.c_str());
 
     return disasm;
   }
@@ -1207,10 +1207,10 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
       stage.entryPoint = p.shaders[i].entryPoint;
 
       stage.stage = ShaderStage::Compute;
-      if(p.shaders[i].mapping)
-        stage.bindpointMapping = *p.shaders[i].mapping;
-      if(p.shaders[i].refl)
-        stage.reflection = p.shaders[i].refl;
+      if(p.shaders[i].GetMapping())
+        stage.bindpointMapping = *p.shaders[i].GetMapping();
+      if(p.shaders[i].GetReflection())
+        stage.reflection = p.shaders[i].GetReflection();
 
       stage.specialization.resize(p.shaders[i].specialization.size());
       for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -1285,10 +1285,10 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
       stages[i]->entryPoint = p.shaders[i].entryPoint;
 
       stages[i]->stage = StageFromIndex(i);
-      if(p.shaders[i].mapping)
-        stages[i]->bindpointMapping = *p.shaders[i].mapping;
-      if(p.shaders[i].refl)
-        stages[i]->reflection = p.shaders[i].refl;
+      if(p.shaders[i].GetMapping())
+        stages[i]->bindpointMapping = *p.shaders[i].GetMapping();
+      if(p.shaders[i].GetReflection())
+        stages[i]->reflection = p.shaders[i].GetReflection();
 
       stages[i]->specialization.resize(p.shaders[i].specialization.size());
       for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -953,6 +953,10 @@ struct ResourceInfo
 
   ImageInfo imageInfo;
 
+  // set for sparse, external or linear images which can be written without the write being visible
+  // to us through a command buffer submission.
+  bool untrackedWrites = false;
+
   bool IsSparse() const { return pages[0] != NULL; }
   void Update(uint32_t numBindings, const VkSparseMemoryBind *pBindings);
   void Update(uint32_t numBindings, const VkSparseImageMemoryBind *pBindings);
@@ -25,6 +25,7 @@
 #include "vk_shader_cache.h"
 #include "common/shader_cache.h"
 #include "data/glsl_shaders.h"
+#include "driver/shaders/spirv/spirv_reflect_cache.h"
 #include "strings/string_utils.h"
 
 enum class FeatureCheck
@@ -90,6 +91,39 @@ static const BuiltinShaderConfig builtinShaders[] = {
 RDCCOMPILE_ASSERT(ARRAY_COUNT(builtinShaders) == arraydim<BuiltinShader>(),
                   "Missing built-in shader config");
 
+static uint32_t GetSPIRVHash(const rdcspv::CompilationSettings &settings, const std::string &src)
+{
+  uint32_t hash = strhash(src.c_str());
+
+  char typestr[3] = {'a', 'a', 0};
+  typestr[0] += (char)settings.stage;
+  typestr[1] += (char)settings.lang;
+  return strhash(typestr, hash);
+}
+
+// a built-in shader that missed the cache and needs to be compiled
+struct BuiltinShaderCompile
+{
+  uint32_t hash;
+  rdcspv::CompilationSettings settings;
+  std::string src;
+
+  SPIRVBlob spirv;
+  std::string errors;
+};
+
+// compiles every shader in parallel. Each compile creates its own glslang shader and program so
+// they don't share any state, and results are written to the compile's own slot.
+static void CompileBuiltinShaders(std::vector<BuiltinShaderCompile> &compiles)
+{
+  Threading::ParallelFor((uint32_t)compiles.size(), [&compiles](uint32_t i) {
+    BuiltinShaderCompile &compile = compiles[i];
+
+    compile.spirv = new std::vector<uint32_t>();
+    compile.errors = rdcspv::Compile(compile.settings, {compile.src}, *compile.spirv);
+  });
+}
+
 struct VulkanBlobShaderCallbacks
 {
   bool Create(uint32_t size, byte *data, SPIRVBlob *ret) const
@@ -135,10 +169,17 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
   if(driverVersion.RunningOnMetal())
     m_GlobalDefines += "#define METAL_BACKEND\n";
 
-  std::string src;
   rdcspv::CompilationSettings compileSettings;
   compileSettings.lang = rdcspv::InputLanguage::VulkanGLSL;
 
+  // gather the built-in shaders we need, fetching any that are already cached and listing the rest
+  // to be compiled. Identical sources share a single compile.
+  const size_t NoCompile = ~size_t(0);
+  bool builtinUsed[arraydim<BuiltinShader>()] = {};
+  size_t builtinCompile[arraydim<BuiltinShader>()] = {};
+  std::vector<BuiltinShaderCompile> compiles;
+  std::map<uint32_t, size_t> compileLookup;
+
   for(auto i : indices<BuiltinShader>())
   {
     const BuiltinShaderConfig &config = builtinShaders[i];
@@ -179,11 +220,53 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
     if(config.stage == rdcspv::ShaderStage::Geometry && !features.geometryShader)
       continue;
 
-    src = GenerateGLSLShader(GetDynamicEmbeddedResource(config.resource), eShaderVulkan, 430,
-                             m_GlobalDefines);
+    builtinUsed[i] = true;
+    builtinCompile[i] = NoCompile;
 
     compileSettings.stage = config.stage;
-    std::string err = GetSPIRVBlob(compileSettings, src, m_BuiltinShaderBlobs[i]);
+
+    std::string src = GenerateGLSLShader(GetDynamicEmbeddedResource(config.resource),
+                                         eShaderVulkan, 430, m_GlobalDefines);
+
+    uint32_t hash = GetSPIRVHash(compileSettings, src);
+
+    auto cacheIt = m_ShaderCache.find(hash);
+    if(cacheIt != m_ShaderCache.end())
+    {
+      m_BuiltinShaderBlobs[i] = cacheIt->second;
+      continue;
+    }
+
+    auto compileIt = compileLookup.find(hash);
+    if(compileIt != compileLookup.end())
+    {
+      builtinCompile[i] = compileIt->second;
+      continue;
+    }
+
+    builtinCompile[i] = compiles.size();
+    compileLookup[hash] = compiles.size();
+    compiles.push_back({hash, compileSettings, src, NULL, std::string()});
+  }
+
+  CompileBuiltinShaders(compiles);
+
+  // merge the results in order, so the cache contents don't depend on which compile finished first
+  for(BuiltinShaderCompile &compile : compiles)
+    compile.errors = CacheSPIRVBlob(compile.hash, compile.spirv, compile.errors, compile.spirv);
+
+  for(auto i : indices<BuiltinShader>())
+  {
+    if(!builtinUsed[i])
+      continue;
+
+    std::string err;
+
+    if(builtinCompile[i] != NoCompile)
+    {
+      m_BuiltinShaderBlobs[i] = compiles[builtinCompile[i]].spirv;
+      err = compiles[builtinCompile[i]].errors;
+    }
 
     if(!err.empty() || m_BuiltinShaderBlobs[i] == VK_NULL_HANDLE)
     {
@@ -225,6 +308,8 @@ VulkanShaderCache::~VulkanShaderCache()
 
   for(size_t i = 0; i < ARRAY_COUNT(m_BuiltinShaderModules); i++)
     m_pDriver->vkDestroyShaderModule(m_Device, m_BuiltinShaderModules[i], NULL);
+
+  rdcspv::GetReflectionCache().Save();
 }
 
 std::string VulkanShaderCache::GetSPIRVBlob(const rdcspv::CompilationSettings &settings,
@@ -232,12 +317,7 @@ std::string VulkanShaderCache::GetSPIRVBlob(const rdcspv::CompilationSettings &s
 {
   RDCASSERT(!src.empty());
 
-  uint32_t hash = strhash(src.c_str());
-
-  char typestr[3] = {'a', 'a', 0};
-  typestr[0] += (char)settings.stage;
-  typestr[1] += (char)settings.lang;
-  hash = strhash(typestr, hash);
+  uint32_t hash = GetSPIRVHash(settings, src);
 
   if(m_ShaderCache.find(hash) != m_ShaderCache.end())
   {
@@ -248,6 +328,12 @@ std::string VulkanShaderCache::GetSPIRVBlob(const rdcspv::CompilationSettings &s
   SPIRVBlob spirv = new std::vector<uint32_t>();
   std::string errors = rdcspv::Compile(settings, {src}, *spirv);
 
+  return CacheSPIRVBlob(hash, spirv, errors, outBlob);
+}
+
+std::string VulkanShaderCache::CacheSPIRVBlob(uint32_t hash, SPIRVBlob spirv,
+                                              const std::string &errors, SPIRVBlob &outBlob)
+{
   if(!errors.empty())
   {
     std::string logerror = errors;
@@ -699,3 +785,59 @@ void VulkanShaderCache::MakeComputePipelineInfo(VkComputePipelineCreateInfo &pip
 
   pipeCreateInfo = ret;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
+
+TEST_CASE("Benchmark cold built-in shader compilation", "[.][benchmark][vulkan]")
+{
+  rdcspv::Init();
+  RenderDoc::Inst().RegisterShutdownFunction(&rdcspv::Shutdown);
+
+  std::vector<BuiltinShaderCompile> compiles;
+
+  for(auto i : indices<BuiltinShader>())
+  {
+    const BuiltinShaderConfig &config = builtinShaders[i];
+
+    BuiltinShaderCompile compile;
+    compile.settings.lang = rdcspv::InputLanguage::VulkanGLSL;
+    compile.settings.stage = config.stage;
+    compile.src = GenerateGLSLShader(GetDynamicEmbeddedResource(config.resource), eShaderVulkan,
+                                     430, "");
+    compile.hash = GetSPIRVHash(compile.settings, compile.src);
+    compile.spirv = NULL;
+
+    compiles.push_back(compile);
+  }
+
+  PerformanceTimer timer;
+
+  std::vector<std::vector<uint32_t>> serial(compiles.size());
+  for(size_t i = 0; i < compiles.size(); i++)
+    rdcspv::Compile(compiles[i].settings, {compiles[i].src}, serial[i]);
+
+  double serialTime = timer.GetMilliseconds();
+
+  timer.Restart();
+
+  CompileBuiltinShaders(compiles);
+
+  double parallelTime = timer.GetMilliseconds();
+
+  WARN("Compiling " << compiles.size() << " built-in shaders serially: " << serialTime
+                    << "ms, in parallel: " << parallelTime << "ms with "
+                    << Threading::GetNumHardwareThreads() << " threads");
+
+  for(size_t i = 0; i < compiles.size(); i++)
+  {
+    INFO("Built-in shader " << i << ": " << compiles[i].errors);
+    CHECK(compiles[i].errors.empty());
+    CHECK(*compiles[i].spirv == serial[i]);
+    delete compiles[i].spirv;
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -78,6 +78,9 @@ public:
   std::string GetGlobalDefines() { return m_GlobalDefines; }
   void SetCaching(bool enabled) { m_CacheShaders = enabled; }
 private:
+  std::string CacheSPIRVBlob(uint32_t hash, SPIRVBlob spirv, const std::string &errors,
+                             SPIRVBlob &outBlob);
+
   static const uint32_t m_ShaderCacheMagic = 0xf00d00d5;
   static const uint32_t m_ShaderCacheVersion = 1;
 
@@ -1673,7 +1673,9 @@ VkResult WrappedVulkan::vkCreateImage(VkDevice device, const VkImageCreateInfo *
       // host-visible memory they may only be updated via memory maps, and we want to be sure to
       // correctly copy their initial contents out rather than relying on memory contents (which may
       // not be valid to map from/into if the image isn't in GENERAL layout).
-      if(isSparse || isExternal || isLinear)
+      resInfo.untrackedWrites = isSparse || isExternal || isLinear;
+
+      if(resInfo.untrackedWrites)
       {
         GetResourceManager()->MarkDirtyResource(id);
 
@@ -173,6 +173,10 @@ public:
   bool IsRecvDataWaiting();
 
   bool SendDataBlocking(const void *buf, uint32_t length);
+  // sends a header and a payload from separate buffers in one go, so a buffered stream can
+  // flush its pending bytes together with a large write without copying it
+  bool SendDataBlocking(const void *header, uint32_t headerLength, const void *buf,
+                        uint32_t length);
   bool RecvDataBlocking(void *data, uint32_t length);
   bool RecvDataNonBlocking(void *data, uint32_t &length);
 
@@ -27,11 +27,13 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <string>
@@ -68,6 +70,25 @@ static std::string errno_string(int err)
   return StringFormat::Fmt("Unknown error %d", err);
 }
 
+// sockets are kept non-blocking, so blocking sends and receives wait here for the socket to be
+// ready instead of switching modes and timeouts back and forth around every call
+static bool WaitForSocket(int socket, short events, uint32_t timeoutMS)
+{
+  pollfd pfd = {};
+  pfd.fd = socket;
+  pfd.events = events;
+
+  for(;;)
+  {
+    int ret = poll(&pfd, 1, (int)timeoutMS);
+
+    if(ret < 0 && errno == EINTR)
+      continue;
+
+    return ret > 0;
+  }
+}
+
 namespace Network
 {
 void SocketPostSend();
@@ -140,28 +161,37 @@ Socket *Socket::AcceptClient(uint32_t timeoutMilliseconds)
 
 bool Socket::SendDataBlocking(const void *buf, uint32_t length)
 {
-  if(length == 0)
-    return true;
-
-  uint32_t sent = 0;
+  return SendDataBlocking(NULL, 0, buf, length);
+}
 
-  char *src = (char *)buf;
+bool Socket::SendDataBlocking(const void *header, uint32_t headerLength, const void *buf,
+                              uint32_t length)
+{
+  iovec iov[2];
+  iov[0].iov_base = (void *)header;
+  iov[0].iov_len = headerLength;
+  iov[1].iov_base = (void *)buf;
+  iov[1].iov_len = length;
 
-  int flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
+  iovec *cur = iov;
+  int count = 2;
 
-  timeval oldtimeout = {0};
-  socklen_t len = sizeof(oldtimeout);
-  getsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (char *)&oldtimeout, &len);
+  while(count > 0 && cur->iov_len == 0)
+  {
+    cur++;
+    count--;
+  }
 
-  timeval timeout = {0};
-  timeout.tv_sec = (timeoutMS / 1000);
-  timeout.tv_usec = (timeoutMS % 1000) * 1000;
-  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
+  if(count == 0)
+    return true;
 
-  while(sent < length)
+  while(count > 0)
   {
-    int ret = send(socket, src, length - sent, 0);
+    msghdr msg = {};
+    msg.msg_iov = cur;
+    msg.msg_iovlen = count;
+
+    ssize_t ret = sendmsg((int)socket, &msg, 0);
 
     if(ret <= 0)
     {
@@ -169,12 +199,13 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
 
       if(err == EINTR)
       {
-        // if we hit EINTR, just try again completely. Technically this restarts the timeout but we
-        // expect EINTR to be rare so it's not a big deal.
         continue;
       }
       else if(err == EWOULDBLOCK || err == EAGAIN)
       {
+        if(WaitForSocket((int)socket, POLLOUT, timeoutMS))
+          continue;
+
         RDCWARN("Timeout in send");
         Shutdown();
         return false;
@@ -187,16 +218,22 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
       }
     }
 
-    sent += ret;
-    src += ret;
-  }
-
-  flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+    // skip past whatever was sent, which may end part-way through a buffer
+    size_t sent = (size_t)ret;
 
-  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&oldtimeout, sizeof(oldtimeout));
+    while(count > 0 && sent >= cur->iov_len)
+    {
+      sent -= cur->iov_len;
+      cur++;
+      count--;
+    }
 
-  RDCASSERT(sent == length);
+    if(count > 0)
+    {
+      cur->iov_base = (char *)cur->iov_base + sent;
+      cur->iov_len -= sent;
+    }
+  }
 
   // incredibly ugly hack necessary for android
   SocketPostSend();
@@ -274,18 +311,6 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
 
   char *dst = (char *)buf;
 
-  int flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
-
-  timeval oldtimeout = {0};
-  socklen_t len = sizeof(oldtimeout);
-  getsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&oldtimeout, &len);
-
-  timeval timeout = {0};
-  timeout.tv_sec = (timeoutMS / 1000);
-  timeout.tv_usec = (timeoutMS % 1000) * 1000;
-  setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
-
   while(received < length)
   {
     int ret = recv(socket, dst, length - received, 0);
@@ -307,6 +332,9 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
       }
       else if(err == EWOULDBLOCK || err == EAGAIN)
       {
+        if(WaitForSocket((int)socket, POLLIN, timeoutMS))
+          continue;
+
         RDCWARN("Timeout in recv");
         Shutdown();
         return false;
@@ -323,11 +351,6 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
     dst += ret;
   }
 
-  flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags | O_NONBLOCK);
-
-  setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&oldtimeout, sizeof(oldtimeout));
-
   RDCASSERT(received == length);
 
   return true;
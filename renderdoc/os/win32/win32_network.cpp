@@ -179,12 +179,29 @@ Socket *Socket::AcceptClient(uint32_t timeoutMilliseconds)
 
 bool Socket::SendDataBlocking(const void *buf, uint32_t length)
 {
-  if(length == 0)
-    return true;
+  return SendDataBlocking(NULL, 0, buf, length);
+}
+
+bool Socket::SendDataBlocking(const void *header, uint32_t headerLength, const void *buf,
+                              uint32_t length)
+{
+  WSABUF bufs[2];
+  bufs[0].buf = (CHAR *)header;
+  bufs[0].len = headerLength;
+  bufs[1].buf = (CHAR *)buf;
+  bufs[1].len = length;
 
-  uint32_t sent = 0;
+  WSABUF *cur = bufs;
+  DWORD count = 2;
 
-  char *src = (char *)buf;
+  while(count > 0 && cur->len == 0)
+  {
+    cur++;
+    count--;
+  }
+
+  if(count == 0)
+    return true;
 
   u_long enable = 0;
   ioctlsocket(socket, FIONBIO, &enable);
@@ -196,11 +213,12 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
   DWORD timeout = timeoutMS;
   setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
 
-  while(sent < length)
+  while(count > 0)
   {
-    int ret = send(socket, src, length - sent, 0);
+    DWORD sent = 0;
+    int ret = WSASend(socket, cur, count, &sent, 0, NULL, NULL);
 
-    if(ret <= 0)
+    if(ret != 0 || sent == 0)
     {
       int err = WSAGetLastError();
 
@@ -218,8 +236,19 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
       }
     }
 
-    sent += ret;
-    src += ret;
+    // skip past whatever was sent, which may end part-way through a buffer
+    while(count > 0 && sent >= cur->len)
+    {
+      sent -= cur->len;
+      cur++;
+      count--;
+    }
+
+    if(count > 0)
+    {
+      cur->buf += sent;
+      cur->len -= sent;
+    }
   }
 
   enable = 1;
@@ -227,8 +256,6 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
 
   setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&oldtimeout, sizeof(oldtimeout));
 
-  RDCASSERT(sent == length);
-
   return true;
 }
 
@@ -0,0 +1,350 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "event_search.h"
+#include <algorithm>
+#include <iterator>
+#include "common/common.h"
+
+static rdcstr LowerCase(const rdcstr &str)
+{
+  rdcstr ret = str;
+  for(size_t i = 0; i < ret.size(); i++)
+  {
+    if(ret[i] >= 'A' && ret[i] <= 'Z')
+      ret[i] = char(ret[i] - 'A' + 'a');
+  }
+  return ret;
+}
+
+static uint32_t Trigram(const char *c)
+{
+  return uint32_t(uint8_t(c[0])) | (uint32_t(uint8_t(c[1])) << 8) | (uint32_t(uint8_t(c[2])) << 16);
+}
+
+// sorts and removes duplicates, for lists built in whatever order events were visited
+template <typename T>
+static void SortUnique(rdcarray<T> &list)
+{
+  std::sort(list.begin(), list.end());
+  list.resize(size_t(std::unique(list.begin(), list.end()) - list.begin()));
+}
+
+void EventSearchIndex::Build(const SDFile &file, const rdcarray<DrawcallDescription> &drawcalls)
+{
+  AddDrawcalls(file, drawcalls);
+
+  m_StringLookup.clear();
+
+  for(rdcarray<uint32_t> &events : m_StringEvents)
+    SortUnique(events);
+
+  // strings are visited in index order so each trigram's list is already sorted, but a string can
+  // contain the same trigram more than once
+  for(uint32_t s = 0; s < (uint32_t)m_Strings.size(); s++)
+  {
+    const rdcstr &str = m_Strings[s];
+
+    for(size_t i = 0; i + 3 <= str.size(); i++)
+    {
+      rdcarray<uint32_t> &list = m_Trigrams[Trigram(str.c_str() + i)];
+      if(list.empty() || list.back() != s)
+        list.push_back(s);
+    }
+  }
+
+  SortUnique(m_Resources);
+
+  for(auto chunkIt = m_Numeric.begin(); chunkIt != m_Numeric.end(); ++chunkIt)
+  {
+    for(auto it = chunkIt->second.begin(); it != chunkIt->second.end(); ++it)
+    {
+      NumericColumn &col = it->second;
+
+      rdcarray<uint32_t> order;
+      order.resize(col.values.size());
+      for(uint32_t i = 0; i < (uint32_t)order.size(); i++)
+        order[i] = i;
+
+      // stable so that events stay in order for equal values
+      std::stable_sort(order.begin(), order.end(),
+                       [&col](uint32_t a, uint32_t b) { return col.values[a] < col.values[b]; });
+
+      NumericColumn sorted;
+      sorted.values.resize(order.size());
+      sorted.events.resize(order.size());
+      for(size_t i = 0; i < order.size(); i++)
+      {
+        sorted.values[i] = col.values[order[i]];
+        sorted.events[i] = col.events[order[i]];
+      }
+
+      col.values.swap(sorted.values);
+      col.events.swap(sorted.events);
+    }
+  }
+}
+
+void EventSearchIndex::AddDrawcalls(const SDFile &file,
+                                    const rdcarray<DrawcallDescription> &drawcalls)
+{
+  for(const DrawcallDescription &draw : drawcalls)
+  {
+    AddString(draw.eventId, draw.name);
+
+    for(const APIEvent &ev : draw.events)
+    {
+      if(ev.chunkIndex >= file.chunks.size())
+        continue;
+
+      const SDChunk *chunk = file.chunks[ev.chunkIndex];
+
+      AddString(ev.eventId, chunk->name);
+
+      for(size_t i = 0; i < chunk->NumChildren(); i++)
+      {
+        const SDObject *child = chunk->GetChild(i);
+        AddObject(ev.eventId, chunk->name, child->name, child);
+      }
+    }
+
+    AddDrawcalls(file, draw.children);
+  }
+}
+
+void EventSearchIndex::AddObject(uint32_t eventId, const rdcstr &chunkName, const rdcstr &path,
+                                 const SDObject *obj)
+{
+  switch(obj->type.basetype)
+  {
+    case SDBasic::Chunk:
+    case SDBasic::Struct:
+    {
+      for(size_t i = 0; i < obj->NumChildren(); i++)
+      {
+        const SDObject *child = obj->GetChild(i);
+        AddObject(eventId, chunkName, path + "." + child->name, child);
+      }
+      break;
+    }
+    case SDBasic::Array:
+    {
+      // large arrays of plain numbers are data rather than parameters anyone would search for, and
+      // unpacking them would cost far more than the index itself
+      if(obj->IsPacked())
+        break;
+
+      for(size_t i = 0; i < obj->NumChildren(); i++)
+        AddObject(eventId, chunkName, path, obj->GetChild(i));
+      break;
+    }
+    case SDBasic::Null:
+    case SDBasic::Buffer: break;
+    case SDBasic::String: AddString(eventId, obj->data.str); break;
+    case SDBasic::Resource: m_Resources.push_back({obj->data.basic.id, eventId}); break;
+    case SDBasic::Enum:
+    case SDBasic::UnsignedInteger:
+    case SDBasic::SignedInteger:
+    case SDBasic::Float:
+    case SDBasic::Boolean:
+    case SDBasic::Character:
+    {
+      double value = 0.0;
+
+      if(obj->type.basetype == SDBasic::SignedInteger)
+        value = (double)obj->data.basic.i;
+      else if(obj->type.basetype == SDBasic::Float)
+        value = obj->data.basic.d;
+      else if(obj->type.basetype == SDBasic::Boolean)
+        value = obj->data.basic.b ? 1.0 : 0.0;
+      else if(obj->type.basetype == SDBasic::Character)
+        value = (double)obj->data.basic.c;
+      else
+        value = (double)obj->data.basic.u;
+
+      NumericColumn &col = m_Numeric[chunkName][path];
+      col.values.push_back(value);
+      col.events.push_back(eventId);
+
+      // enums and flags are stringised, so they can be found by name too
+      if(!obj->data.str.empty())
+        AddString(eventId, obj->data.str);
+      break;
+    }
+  }
+}
+
+void EventSearchIndex::AddString(uint32_t eventId, const rdcstr &str)
+{
+  if(str.empty())
+    return;
+
+  rdcstr lower = LowerCase(str);
+
+  auto it = m_StringLookup.find(lower);
+  uint32_t idx;
+
+  if(it == m_StringLookup.end())
+  {
+    idx = (uint32_t)m_Strings.size();
+    m_StringLookup[lower] = idx;
+    m_Strings.push_back(lower);
+    m_StringEvents.push_back({});
+  }
+  else
+  {
+    idx = it->second;
+  }
+
+  rdcarray<uint32_t> &events = m_StringEvents[idx];
+
+  // most strings are added many times in a row from the same event, skip those cheaply here
+  if(events.empty() || events.back() != eventId)
+    events.push_back(eventId);
+}
+
+rdcarray<uint32_t> EventSearchIndex::FindText(const rdcstr &text) const
+{
+  rdcarray<uint32_t> ret;
+
+  if(text.empty())
+    return ret;
+
+  rdcstr needle = LowerCase(text);
+
+  // the strings that contain every trigram in the needle, and so might contain the needle itself
+  rdcarray<uint32_t> candidates;
+
+  if(needle.size() < 3)
+  {
+    candidates.resize(m_Strings.size());
+    for(uint32_t i = 0; i < (uint32_t)candidates.size(); i++)
+      candidates[i] = i;
+  }
+  else
+  {
+    rdcarray<const rdcarray<uint32_t> *> lists;
+
+    for(size_t i = 0; i + 3 <= needle.size(); i++)
+    {
+      auto it = m_Trigrams.find(Trigram(needle.c_str() + i));
+
+      // a trigram that appears nowhere means nothing can match
+      if(it == m_Trigrams.end())
+        return ret;
+
+      lists.push_back(&it->second);
+    }
+
+    // intersect starting from the shortest list, so the working set only shrinks
+    std::sort(lists.begin(), lists.end(),
+              [](const rdcarray<uint32_t> *a, const rdcarray<uint32_t> *b) {
+                return a->size() < b->size();
+              });
+
+    candidates = *lists[0];
+
+    for(size_t l = 1; l < lists.size() && !candidates.empty(); l++)
+    {
+      rdcarray<uint32_t> intersected;
+      intersected.reserve(candidates.size());
+      std::set_intersection(candidates.begin(), candidates.end(), lists[l]->begin(),
+                            lists[l]->end(), std::back_inserter(intersected));
+      candidates.swap(intersected);
+    }
+  }
+
+  for(uint32_t s : candidates)
+  {
+    if(m_Strings[s].contains(needle))
+      ret.append(m_StringEvents[s].data(), m_StringEvents[s].size());
+  }
+
+  SortUnique(ret);
+
+  return ret;
+}
+
+rdcarray<uint32_t> EventSearchIndex::FindResource(ResourceId id) const
+{
+  rdcarray<uint32_t> ret;
+
+  auto it = std::lower_bound(m_Resources.begin(), m_Resources.end(),
+                             rdcpair<ResourceId, uint32_t>(id, 0));
+
+  // the pairs are sorted and unique, so the events are too
+  for(; it != m_Resources.end() && it->first == id; ++it)
+    ret.push_back(it->second);
+
+  return ret;
+}
+
+rdcarray<uint32_t> EventSearchIndex::FindParameter(const rdcstr &chunkName, const rdcstr &param,
+                                                   CompareFunction compare, double value) const
+{
+  rdcarray<uint32_t> ret;
+
+  for(auto chunkIt = m_Numeric.begin(); chunkIt != m_Numeric.end(); ++chunkIt)
+  {
+    if(!chunkName.empty() && chunkIt->first != chunkName)
+      continue;
+
+    auto it = chunkIt->second.find(param);
+    if(it == chunkIt->second.end())
+      continue;
+
+    const NumericColumn &col = it->second;
+
+    // the matching values are one or two contiguous ranges of the sorted column
+    size_t lower =
+        size_t(std::lower_bound(col.values.begin(), col.values.end(), value) - col.values.begin());
+    size_t upper =
+        size_t(std::upper_bound(col.values.begin(), col.values.end(), value) - col.values.begin());
+
+    rdcpair<size_t, size_t> ranges[2] = {{0, 0}, {0, 0}};
+
+    switch(compare)
+    {
+      case CompareFunction::Never: break;
+      case CompareFunction::AlwaysTrue: ranges[0] = {0, col.values.size()}; break;
+      case CompareFunction::Less: ranges[0] = {0, lower}; break;
+      case CompareFunction::LessEqual: ranges[0] = {0, upper}; break;
+      case CompareFunction::Greater: ranges[0] = {upper, col.values.size()}; break;
+      case CompareFunction::GreaterEqual: ranges[0] = {lower, col.values.size()}; break;
+      case CompareFunction::Equal: ranges[0] = {lower, upper}; break;
+      case CompareFunction::NotEqual:
+        ranges[0] = {0, lower};
+        ranges[1] = {upper, col.values.size()};
+        break;
+    }
+
+    for(const rdcpair<size_t, size_t> &range : ranges)
+      ret.append(col.events.data() + range.first, range.second - range.first);
+  }
+
+  SortUnique(ret);
+
+  return ret;
+}
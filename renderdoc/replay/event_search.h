@@ -0,0 +1,79 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <map>
+#include "api/replay/renderdoc_replay.h"
+
+// An index over the events in a capture for searching, built once from the structured data and
+// drawcall list. Text is matched case-insensitively as a substring of chunk names, drawcall names
+// and string parameters, using a trigram index over the unique strings so that only strings
+// sharing every trigram with the query are compared. Resource and numeric parameters are kept in
+// sorted tables so they're found by binary search rather than walking the structured data.
+class EventSearchIndex
+{
+public:
+  // the structured file isn't referenced after building
+  void Build(const SDFile &file, const rdcarray<DrawcallDescription> &drawcalls);
+
+  // each of these returns eventIds in ascending order with no duplicates
+  rdcarray<uint32_t> FindText(const rdcstr &text) const;
+  rdcarray<uint32_t> FindResource(ResourceId id) const;
+  // parameters inside structs are named with '.' between members, e.g. "pRegions.size". Every
+  // element of an array is named the same as the array. If chunkName is empty, any chunk with the
+  // parameter is searched.
+  rdcarray<uint32_t> FindParameter(const rdcstr &chunkName, const rdcstr &param,
+                                   CompareFunction compare, double value) const;
+
+private:
+  void AddDrawcalls(const SDFile &file, const rdcarray<DrawcallDescription> &drawcalls);
+  void AddObject(uint32_t eventId, const rdcstr &chunkName, const rdcstr &path,
+                 const SDObject *obj);
+  void AddString(uint32_t eventId, const rdcstr &str);
+
+  // unique lowercase strings, and the sorted events each one appears in
+  rdcarray<rdcstr> m_Strings;
+  rdcarray<rdcarray<uint32_t>> m_StringEvents;
+
+  // only used while building, to find the existing index for a string
+  std::map<rdcstr, uint32_t> m_StringLookup;
+
+  // for each trigram, the sorted indices of the strings it appears in
+  std::map<uint32_t, rdcarray<uint32_t>> m_Trigrams;
+
+  // every resource referenced along with the event it's referenced in, sorted
+  rdcarray<rdcpair<ResourceId, uint32_t>> m_Resources;
+
+  // the values of one parameter in ascending order, along with the event each came from
+  struct NumericColumn
+  {
+    rdcarray<double> values;
+    rdcarray<uint32_t> events;
+  };
+
+  // keyed by chunk name, then parameter name
+  std::map<rdcstr, std::map<rdcstr, NumericColumn>> m_Numeric;
+};
@@ -97,6 +97,16 @@ void DoSerialise(SerialiserType &ser, EnvironmentModification &el)
   SIZE_CHECK(56);
 }
 
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, CaptureCostData &el)
+{
+  SERIALISE_MEMBER(name);
+  SERIALISE_MEMBER(count);
+  SERIALISE_MEMBER(microseconds);
+
+  SIZE_CHECK(40);
+}
+
 template <class SerialiserType>
 void DoSerialise(SerialiserType &ser, CaptureOptions &el)
 {
@@ -2216,6 +2226,7 @@ INSTANTIATE_SERIALISE_TYPE(ExecuteResult)
 INSTANTIATE_SERIALISE_TYPE(PathEntry)
 INSTANTIATE_SERIALISE_TYPE(SectionProperties)
 INSTANTIATE_SERIALISE_TYPE(EnvironmentModification)
+INSTANTIATE_SERIALISE_TYPE(CaptureCostData)
 INSTANTIATE_SERIALISE_TYPE(CaptureOptions)
 INSTANTIATE_SERIALISE_TYPE(ResourceFormat)
 INSTANTIATE_SERIALISE_TYPE(Bindpoint)
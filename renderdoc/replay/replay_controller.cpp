@@ -27,6 +27,7 @@
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
+#include "core/replay_trace.h"
 #include "driver/ihv/amd/amd_isa.h"
 #include "driver/ihv/amd/amd_rgp.h"
 #include "jpeg-compressor/jpgd.h"
@@ -215,17 +216,24 @@ ReplayController::~ReplayController()
 void ReplayController::SetFrameEvent(uint32_t eventId, bool force)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::SetFrameEvent");
 
   if(eventId != m_EventID || force)
   {
     m_EventID = eventId;
 
-    m_pDevice->ReplayLog(eventId, eReplay_WithoutDraw);
+    {
+      REPLAY_TRACE_SCOPE("IReplayDriver::ReplayLog");
+      m_pDevice->ReplayLog(eventId, eReplay_WithoutDraw);
+    }
 
     for(size_t i = 0; i < m_Outputs.size(); i++)
       m_Outputs[i]->SetFrameEvent(eventId);
 
-    m_pDevice->ReplayLog(eventId, eReplay_OnlyDraw);
+    {
+      REPLAY_TRACE_SCOPE("IReplayDriver::ReplayLog");
+      m_pDevice->ReplayLog(eventId, eReplay_OnlyDraw);
+    }
 
     FetchPipelineState(eventId);
   }
@@ -288,6 +296,7 @@ rdcstr ReplayController::DisassembleShader(ResourceId pipeline, const ShaderRefl
                                            const char *target)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::DisassembleShader");
 
   for(const std::string &t : m_GCNTargets)
     if(t == target)
@@ -538,6 +547,7 @@ void ReplayController::AddFakeMarkers()
 rdcarray<CounterResult> ReplayController::FetchCounters(const rdcarray<GPUCounter> &counters)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::FetchCounters");
 
   std::vector<GPUCounter> counterArray(counters.begin(), counters.end());
 
@@ -604,6 +614,7 @@ ShaderReflection *ReplayController::GetShader(ResourceId pipeline, ResourceId sh
 rdcarray<EventUsage> ReplayController::GetUsage(ResourceId id)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::GetUsage");
 
   id = m_pDevice->GetLiveID(id);
   if(id == ResourceId())
@@ -614,6 +625,7 @@ rdcarray<EventUsage> ReplayController::GetUsage(ResourceId id)
 MeshFormat ReplayController::GetPostVSData(uint32_t instID, uint32_t viewID, MeshDataStage stage)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::GetPostVSData");
 
   DrawcallDescription *draw = GetDrawcallByEID(m_EventID);
 
@@ -633,6 +645,7 @@ MeshFormat ReplayController::GetPostVSData(uint32_t instID, uint32_t viewID, Mes
 bytebuf ReplayController::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::GetBufferData");
 
   bytebuf retData;
 
@@ -655,6 +668,7 @@ bytebuf ReplayController::GetBufferData(ResourceId buff, uint64_t offset, uint64
 bytebuf ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::GetTextureData");
 
   bytebuf ret;
 
@@ -666,7 +680,10 @@ bytebuf ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint
     return ret;
   }
 
-  m_pDevice->GetTextureData(liveId, arrayIdx, mip, GetTextureDataParams(), ret);
+  {
+    REPLAY_TRACE_SCOPE("IReplayDriver::GetTextureData");
+    m_pDevice->GetTextureData(liveId, arrayIdx, mip, GetTextureDataParams(), ret);
+  }
 
   return ret;
 }
@@ -674,6 +691,7 @@ bytebuf ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint
 bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::SaveTexture");
 
   TextureSave sd = saveData;    // mutable copy
   ResourceId liveid = m_pDevice->GetLiveID(sd.resourceId);
@@ -1550,6 +1568,7 @@ rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, ui
                                                            uint32_t sampleIdx, CompType typeHint)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::PixelHistory");
 
   rdcarray<PixelModification> ret;
 
@@ -1660,6 +1679,7 @@ ShaderDebugTrace *ReplayController::DebugVertex(uint32_t vertid, uint32_t instid
                                                 uint32_t instOffset, uint32_t vertOffset)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::DebugVertex");
 
   ShaderDebugTrace *ret = new ShaderDebugTrace;
 
@@ -1674,6 +1694,7 @@ ShaderDebugTrace *ReplayController::DebugPixel(uint32_t x, uint32_t y, uint32_t
                                                uint32_t primitive)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::DebugPixel");
 
   ShaderDebugTrace *ret = new ShaderDebugTrace;
 
@@ -1687,6 +1708,7 @@ ShaderDebugTrace *ReplayController::DebugPixel(uint32_t x, uint32_t y, uint32_t
 ShaderDebugTrace *ReplayController::DebugThread(const uint32_t groupid[3], const uint32_t threadid[3])
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::DebugThread");
 
   ShaderDebugTrace *ret = new ShaderDebugTrace;
 
@@ -1709,6 +1731,7 @@ rdcarray<ShaderVariable> ReplayController::GetCBufferVariableContents(
     ResourceId buffer, uint64_t offs)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::GetCBufferVariableContents");
 
   bytebuf data;
   if(buffer != ResourceId())
@@ -1923,6 +1946,7 @@ rdcpair<ResourceId, rdcstr> ReplayController::BuildTargetShader(
     const ShaderCompileFlags &compileFlags, ShaderStage type)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::BuildTargetShader");
 
   rdcarray<ShaderEncoding> encodings = m_pDevice->GetTargetShaderEncodings();
 
@@ -1958,6 +1982,7 @@ rdcpair<ResourceId, rdcstr> ReplayController::BuildCustomShader(
     const ShaderCompileFlags &compileFlags, ShaderStage type)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::BuildCustomShader");
 
   ResourceId id;
   std::string errs;
@@ -2009,6 +2034,7 @@ void ReplayController::FreeCustomShader(ResourceId id)
 void ReplayController::ReplaceResource(ResourceId from, ResourceId to)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::ReplaceResource");
 
   m_pDevice->ReplaceResource(from, to);
 
@@ -2022,6 +2048,7 @@ void ReplayController::ReplaceResource(ResourceId from, ResourceId to)
 void ReplayController::RemoveReplacement(ResourceId id)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::RemoveReplacement");
 
   m_pDevice->RemoveReplacement(id);
 
@@ -2129,6 +2156,7 @@ APIProperties ReplayController::GetAPIProperties()
 void ReplayController::FetchPipelineState(uint32_t eventId)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayController::FetchPipelineState");
 
   m_pDevice->SavePipelineState(eventId);
 
@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "common/common.h"
+#include "core/replay_trace.h"
 #include "maths/formatpacking.h"
 #include "maths/matrix.h"
 #include "strings/string_utils.h"
@@ -223,6 +224,7 @@ void ReplayOutput::SetFrameEvent(int eventId)
 void ReplayOutput::RefreshOverlay()
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayOutput::RefreshOverlay");
 
   DrawcallDescription *draw = m_pRenderer->GetDrawcallByEID(m_EventID);
 
@@ -440,6 +442,7 @@ PixelValue ReplayOutput::PickPixel(ResourceId tex, bool customShader, uint32_t x
                                    uint32_t sliceFace, uint32_t mip, uint32_t sample)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayOutput::PickPixel");
 
   PixelValue ret;
 
@@ -468,8 +471,11 @@ PixelValue ReplayOutput::PickPixel(ResourceId tex, bool customShader, uint32_t x
     typeHint = CompType::Typeless;
   }
 
-  m_pDevice->PickPixel(m_pDevice->GetLiveID(tex), x, y, sliceFace, mip, sample, typeHint,
-                       ret.floatValue);
+  {
+    REPLAY_TRACE_SCOPE("IReplayDriver::PickPixel");
+    m_pDevice->PickPixel(m_pDevice->GetLiveID(tex), x, y, sliceFace, mip, sample, typeHint,
+                         ret.floatValue);
+  }
 
   return ret;
 }
@@ -477,6 +483,7 @@ PixelValue ReplayOutput::PickPixel(ResourceId tex, bool customShader, uint32_t x
 rdcpair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventId, uint32_t x, uint32_t y)
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayOutput::PickVertex");
 
   DrawcallDescription *draw = m_pRenderer->GetDrawcallByEID(eventId);
 
@@ -533,6 +540,7 @@ rdcpair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventId, uint32_t
       if(fmt.vertexResourceId != ResourceId())
         cfg.position.vertexByteOffset = fmt.vertexByteOffset + elemOffset;
 
+      REPLAY_TRACE_SCOPE("IReplayDriver::PickVertex");
       uint32_t vert = m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y);
       if(vert != ~0U)
       {
@@ -544,6 +552,7 @@ rdcpair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventId, uint32_t
   }
   else
   {
+    REPLAY_TRACE_SCOPE("IReplayDriver::PickVertex");
     return make_rdcpair(m_pDevice->PickVertex(m_EventID, m_Width, m_Height, cfg, x, y),
                         m_RenderData.meshDisplay.curInstance);
   }
@@ -649,6 +658,7 @@ void ReplayOutput::DisplayContext()
 void ReplayOutput::Display()
 {
   CHECK_REPLAY_THREAD();
+  REPLAY_TRACE_SCOPE("ReplayOutput::Display");
 
   if(m_pDevice->CheckResizeOutputWindow(m_MainOutput.outputID))
   {
@@ -958,5 +968,6 @@ void ReplayOutput::DisplayMesh()
 
   mesh.position.meshColor = drawItself;
 
+  REPLAY_TRACE_SCOPE("IReplayDriver::RenderMesh");
   m_pDevice->RenderMesh(m_EventID, secondaryDraws, mesh);
 }
@@ -34,13 +34,17 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
   if(!f)
     return ReplayStatus::FileIOFailed;
 
-  std::string str;
+  // events are written out as we go rather than accumulated, so memory use doesn't grow with the
+  // number of chunks
+  StreamWriter writer(f, Ownership::Stream);
 
   // add header, customise this as needed.
-  str = R"({
+  std::string str = R"({
   "displayTimeUnit": "ns",
   "traceEvents": [)";
 
+  writer.Write(str.data(), str.size());
+
   const char *category = "Initialisation";
 
   // stupid JSON not allowing trailing ,s :(
@@ -54,24 +58,24 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
     if(chunk->metadata.chunkID == (uint32_t)SystemChunk::FirstDriverChunk + 1)
       category = "Frame Capture";
 
-    if(!first)
-      str += ",";
-
-    first = false;
-
-    const char *fmt = R"(
+    const char *fmt = R"(%s
     { "name": "%s", "cat": "%s", "ph": "B", "ts": %llu, "pid": 5, "tid": %u },
     { "ph": "E", "ts": %llu, "pid": 5, "tid": %u })";
 
     if(chunk->metadata.durationMicro == 0)
     {
-      fmt = R"(
+      fmt = R"(%s
     { "name": "%s", "cat": "%s", "ph": "i", "ts": %llu, "pid": 5, "tid": %u })";
     }
 
-    str += StringFormat::Fmt(
-        fmt, chunk->name.c_str(), category, chunk->metadata.timestampMicro, chunk->metadata.threadID,
-        chunk->metadata.timestampMicro + chunk->metadata.durationMicro, chunk->metadata.threadID);
+    str = StringFormat::Fmt(fmt, first ? "" : ",", chunk->name.c_str(), category,
+                            chunk->metadata.timestampMicro, chunk->metadata.threadID,
+                            chunk->metadata.timestampMicro + chunk->metadata.durationMicro,
+                            chunk->metadata.threadID);
+
+    writer.Write(str.data(), str.size());
+
+    first = false;
 
     if(progress)
       progress(float(i) / float(numChunks));
@@ -83,13 +87,13 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
     progress(1.0f);
 
   // end trace events
-  str += "\n  ]\n}";
+  str = "\n  ]\n}";
 
-  FileIO::fwrite(str.data(), 1, str.size(), f);
+  writer.Write(str.data(), str.size());
 
-  FileIO::fclose(f);
+  writer.Finish();
 
-  return ReplayStatus::Succeeded;
+  return writer.IsErrored() ? ReplayStatus::FileIOFailed : ReplayStatus::Succeeded;
 }
 
 static ConversionRegistration XMLConversionRegistration(
@@ -56,6 +56,10 @@ inline float StructuredProgress(float progress)
   return 0.2f + 0.8f * progress;
 }
 
+// section data is encoded and decoded this many bytes at a time. It's a multiple of the hex line
+// length so only the last piece can end on a partial line.
+static const size_t StreamPieceSize = 64 * 1024;
+
 struct xml_file_writer : pugi::xml_writer
 {
   StreamWriter stream;
@@ -65,6 +69,95 @@ struct xml_file_writer : pugi::xml_writer
   }
 
   void write(const void *data, size_t size) { stream.Write(data, size); }
+  void write_str(const std::string &str) { stream.Write(str.data(), str.size()); }
+  // escapes text content the same way pugixml does when printing pcdata
+  void write_escaped(const char *str, size_t len)
+  {
+    const char *end = str + len;
+    while(str < end)
+    {
+      const char *run = str;
+      while(str < end && *str != '&' && *str != '<' && *str != '>')
+        str++;
+
+      stream.Write(run, str - run);
+
+      if(str < end)
+      {
+        if(*str == '&')
+          stream.Write("&amp;", 5);
+        else if(*str == '<')
+          stream.Write("&lt;", 4);
+        else
+          stream.Write("&gt;", 4);
+        str++;
+      }
+    }
+  }
+};
+
+// pulls the document in from a stream a piece at a time, so that only a window around the current
+// element is held in memory rather than the whole text
+struct xml_stream_reader
+{
+  StreamReader &stream;
+  std::string window;
+  size_t pos = 0;
+  // the largest the window has grown, to check the memory used stays bounded
+  size_t peakWindow = 0;
+
+  xml_stream_reader(StreamReader &s) : stream(s) {}
+  bool Fill()
+  {
+    uint64_t remaining = stream.GetSize() - stream.GetOffset();
+    if(remaining == 0 || stream.IsErrored())
+      return false;
+
+    size_t size = (size_t)RDCMIN(remaining, (uint64_t)StreamPieceSize);
+    size_t oldSize = window.size();
+    window.resize(oldSize + size);
+    peakWindow = RDCMAX(peakWindow, window.size());
+    return stream.Read(&window[oldSize], size);
+  }
+
+  // returns the offset in the window of the next occurrence of str at or after from, reading more
+  // of the stream as necessary. Offsets are valid until the next Consume()
+  size_t Find(const char *str, size_t from)
+  {
+    size_t len = strlen(str);
+
+    for(;;)
+    {
+      size_t idx = window.find(str, from);
+      if(idx != std::string::npos)
+        return idx;
+
+      // don't rescan what we've already searched, but allow for a match straddling the new data
+      if(window.size() >= len)
+        from = RDCMAX(from, window.size() - len + 1);
+
+      if(!Fill())
+        return std::string::npos;
+    }
+  }
+
+  void Consume(size_t end)
+  {
+    pos = end;
+
+    // discard the consumed text once it's a significant portion of the window
+    if(pos >= StreamPieceSize)
+    {
+      window.erase(0, pos);
+      pos = 0;
+    }
+  }
+
+  float Progress()
+  {
+    uint64_t size = stream.GetSize();
+    return size > 0 ? float(stream.GetOffset()) / float(size) : 1.0f;
+  }
 };
 
 // avoid &, <, and > since they throw off the ascii alignment
@@ -86,7 +179,9 @@ static constexpr byte FromHex(const char c)
                                      : (c >= 'a' && c <= 'f' ? byte(c - 'a') + 10 : 0));
 }
 
-static void HexEncode(const std::vector<byte> &in, std::string &out)
+// encodes a piece of data into lines of hex, not including the leading newline. Only the final
+// piece may have a length that isn't a multiple of the line length
+static void HexEncode(const byte *in, size_t size, std::string &out)
 {
   const size_t bytesPerLine = 32;
   const size_t bytesPerGroup = 4;
@@ -97,17 +192,17 @@ static void HexEncode(const std::vector<byte> &in, std::string &out)
   // - 4 characters per line (3x space between hex and ascii, newline)
   // - 1 character per group (space)
   // - 2 characters for leading/trailing newline
-  out.reserve(in.size() * 3 + (in.size() / bytesPerLine) * 4 + (in.size() / bytesPerGroup) + 2);
-
-  // leading newline
-  out = "\n";
+  out.clear();
+  out.reserve(size * 3 + (size / bytesPerLine) * 4 + (size / bytesPerGroup) + 2);
 
   // accumulate ascii representation for each line
   std::string ascii;
 
   size_t i = 0;
-  for(byte c : in)
+  for(const byte *end = in + size; in < end; in++)
   {
+    byte c = *in;
+
     out.push_back(digit[(c & 0xf0) >> 4]);
     out.push_back(digit[(c & 0x0f) >> 0]);
 
@@ -271,16 +366,62 @@ static void Obj2XML(pugi::xml_node &parent, SDObject &child)
   }
 }
 
+static void Chunk2XML(pugi::xml_node &xChunks, SDChunk *chunk)
+{
+  pugi::xml_node xChunk = xChunks.append_child("chunk");
+
+  xChunk.append_attribute("id") = chunk->metadata.chunkID;
+  xChunk.append_attribute("name") = chunk->name.c_str();
+  xChunk.append_attribute("length") = chunk->metadata.length;
+  if(chunk->metadata.threadID)
+    xChunk.append_attribute("threadID") = chunk->metadata.threadID;
+  if(chunk->metadata.timestampMicro)
+    xChunk.append_attribute("timestamp") = chunk->metadata.timestampMicro;
+  if(chunk->metadata.durationMicro >= 0)
+    xChunk.append_attribute("duration") = chunk->metadata.durationMicro;
+  if(chunk->metadata.flags & SDChunkFlags::HasCallstack)
+  {
+    pugi::xml_node stack = xChunk.append_child("callstack");
+
+    for(size_t i = 0; i < chunk->metadata.callstack.size(); i++)
+    {
+      stack.append_child("address").text() = chunk->metadata.callstack[i];
+    }
+  }
+
+  if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
+  {
+    xChunk.append_attribute("opaque") = true;
+
+    RDCASSERT(!chunk->data.children.empty());
+    pugi::xml_node opaque = xChunk.append_child("buffer");
+    opaque.append_attribute("byteLength") = chunk->data.children[0]->type.byteSize;
+    opaque.text() = chunk->data.children[0]->data.basic.u;
+  }
+  else
+  {
+    for(size_t o = 0; o < chunk->data.children.size(); o++)
+      Obj2XML(xChunk, *chunk->data.children[o]);
+  }
+}
+
+// the document is written out as it's generated - only the element currently being written is
+// built as a DOM, and section data is encoded piece by piece - so memory use doesn't scale with the
+// size of the capture.
 static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, uint64_t version,
                                    const StructuredChunkList &chunks,
                                    RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
+  xml_file_writer writer(filename);
+
+  const char *indent = "\t";
 
-  pugi::xml_node xRoot = doc.append_child("rdc");
+  writer.write_str("<?xml version=\"1.0\"?>\n<rdc>\n");
 
   {
-    pugi::xml_node xHeader = xRoot.append_child("header");
+    pugi::xml_document doc;
+
+    pugi::xml_node xHeader = doc.append_child("header");
 
     pugi::xml_node xDriver = xHeader.append_child("driver");
     xDriver.append_attribute("id") = (uint32_t)file.GetDriver();
@@ -307,6 +448,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
       else
         RDCERR("Unexpected thumbnail format %s", ToStr(th.format).c_str());
     }
+
+    xHeader.print(writer, indent, pugi::format_default, pugi::encoding_auto, 1);
   }
 
   if(progress)
@@ -331,7 +474,9 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
         bool succeeded = reader->SkipBytes(thumbHeader.len) && !reader->IsErrored();
         if(succeeded && (uint32_t)thumbHeader.format < (uint32_t)FileType::Count)
         {
-          pugi::xml_node xExtThumbnail = xRoot.append_child("extended_thumbnail");
+          pugi::xml_document doc;
+
+          pugi::xml_node xExtThumbnail = doc.append_child("extended_thumbnail");
 
           xExtThumbnail.append_attribute("width") = thumbHeader.width;
           xExtThumbnail.append_attribute("height") = thumbHeader.height;
@@ -345,6 +490,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
             xExtThumbnail.text() = "ext_thumb.raw";
           else
             RDCERR("Unexpected extended thumbnail format %s", ToStr(thumbHeader.format).c_str());
+
+          xExtThumbnail.print(writer, indent, pugi::format_default, pugi::encoding_auto, 1);
         }
       }
 
@@ -352,99 +499,83 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
       continue;
     }
 
-    pugi::xml_node xSection = xRoot.append_child("section");
+    writer.write_str("\t<section");
 
     if(props.flags & SectionFlags::ASCIIStored)
-      xSection.append_attribute("ascii");
+      writer.write_str(" ascii=\"\"");
     if(props.flags & SectionFlags::LZ4Compressed)
-      xSection.append_attribute("lz4");
+      writer.write_str(" lz4=\"\"");
     if(props.flags & SectionFlags::ZstdCompressed)
-      xSection.append_attribute("zstd");
-
-    pugi::xml_node name = xSection.append_child("name");
-    name.text() = props.name.c_str();
+      writer.write_str(" zstd=\"\"");
 
-    pugi::xml_node secVer = xSection.append_child("version");
-    secVer.text() = props.version;
+    writer.write_str(">\n\t\t<name>");
+    writer.write_escaped(props.name.c_str(), props.name.size());
+    writer.write_str(
+        StringFormat::Fmt("</name>\n\t\t<version>%llu</version>\n\t\t<type>%u</type>\n",
+                          props.version, (uint32_t)props.type));
 
-    pugi::xml_node type = xSection.append_child("type");
-    type.text() = (uint32_t)props.type;
+    writer.write_str("\t\t<data>");
 
     std::vector<byte> contents;
-    contents.resize((size_t)reader->GetSize());
-    reader->Read(contents.data(), reader->GetSize());
+    contents.resize((size_t)RDCMIN(reader->GetSize(), (uint64_t)StreamPieceSize));
 
-    pugi::xml_node data = xSection.append_child("data");
+    // encode to simple hex. Not efficient, but easy.
+    std::string hexdata;
 
-    if(props.flags & SectionFlags::ASCIIStored)
-    {
-      // insert the contents literally
-      data.text().set((char *)contents.data());
-    }
-    else
+    if(!(props.flags & SectionFlags::ASCIIStored))
+      writer.write_str("\n");
+
+    for(uint64_t offs = 0; offs < reader->GetSize(); offs += contents.size())
     {
-      // encode to simple hex. Not efficient, but easy.
-      std::string hexdata;
-      hexdata.reserve(contents.size() * 2);
-      HexEncode(contents, hexdata);
-      data.text().set(hexdata.c_str());
+      size_t size = (size_t)RDCMIN(reader->GetSize() - offs, (uint64_t)contents.size());
+      reader->Read(contents.data(), size);
+
+      if(props.flags & SectionFlags::ASCIIStored)
+      {
+        // insert the contents literally
+        writer.write_escaped((const char *)contents.data(), size);
+      }
+      else
+      {
+        HexEncode(contents.data(), size, hexdata);
+        writer.write_str(hexdata);
+      }
     }
 
+    writer.write_str("</data>\n\t</section>\n");
+
     delete reader;
   }
 
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xRoot.append_child("chunks");
-
-  xChunks.append_attribute("version") = version;
-
-  for(size_t c = 0; c < chunks.size(); c++)
+  if(chunks.empty())
+  {
+    writer.write_str(StringFormat::Fmt("\t<chunks version=\"%llu\" />\n", version));
+  }
+  else
   {
-    pugi::xml_node xChunk = xChunks.append_child("chunk");
-    SDChunk *chunk = chunks[c];
+    writer.write_str(StringFormat::Fmt("\t<chunks version=\"%llu\">\n", version));
 
-    xChunk.append_attribute("id") = chunk->metadata.chunkID;
-    xChunk.append_attribute("name") = chunk->name.c_str();
-    xChunk.append_attribute("length") = chunk->metadata.length;
-    if(chunk->metadata.threadID)
-      xChunk.append_attribute("threadID") = chunk->metadata.threadID;
-    if(chunk->metadata.timestampMicro)
-      xChunk.append_attribute("timestamp") = chunk->metadata.timestampMicro;
-    if(chunk->metadata.durationMicro >= 0)
-      xChunk.append_attribute("duration") = chunk->metadata.durationMicro;
-    if(chunk->metadata.flags & SDChunkFlags::HasCallstack)
+    for(size_t c = 0; c < chunks.size(); c++)
     {
-      pugi::xml_node stack = xChunk.append_child("callstack");
+      pugi::xml_document doc;
 
-      for(size_t i = 0; i < chunk->metadata.callstack.size(); i++)
-      {
-        stack.append_child("address").text() = chunk->metadata.callstack[i];
-      }
-    }
+      Chunk2XML(doc, chunks[c]);
 
-    if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
-    {
-      xChunk.append_attribute("opaque") = true;
+      doc.first_child().print(writer, indent, pugi::format_default, pugi::encoding_auto, 2);
 
-      RDCASSERT(!chunk->data.children.empty());
-      pugi::xml_node opaque = xChunk.append_child("buffer");
-      opaque.append_attribute("byteLength") = chunk->data.children[0]->type.byteSize;
-      opaque.text() = chunk->data.children[0]->data.basic.u;
-    }
-    else
-    {
-      for(size_t o = 0; o < chunk->data.children.size(); o++)
-        Obj2XML(xChunk, *chunk->data.children[o]);
+      if(progress)
+        progress(StructuredProgress(0.2f + 0.8f * (float(c) / float(chunks.size()))));
     }
 
-    if(progress)
-      progress(StructuredProgress(0.2f + 0.8f * (float(c) / float(chunks.size()))));
+    writer.write_str("\t</chunks>\n");
   }
 
-  xml_file_writer writer(filename);
-  doc.save(writer);
+  writer.write_str("</rdc>\n");
+
+  writer.stream.Finish();
 
   return writer.stream.IsErrored() ? ReplayStatus::FileIOFailed : ReplayStatus::Succeeded;
 }
@@ -542,31 +673,249 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
   return ret;
 }
 
-static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thumb,
+static SDChunk *XML2Chunk(pugi::xml_node &xChunk)
+{
+  SDChunk *chunk = new SDChunk(xChunk.attribute("name").as_string());
+
+  chunk->metadata.chunkID = xChunk.attribute("id").as_uint();
+  chunk->metadata.length = xChunk.attribute("length").as_uint();
+  if(xChunk.attribute("threadID"))
+    chunk->metadata.threadID = xChunk.attribute("threadID").as_ullong();
+  if(xChunk.attribute("timestamp"))
+    chunk->metadata.timestampMicro = xChunk.attribute("timestamp").as_ullong();
+  if(xChunk.attribute("duration"))
+    chunk->metadata.durationMicro = xChunk.attribute("duration").as_ullong();
+
+  pugi::xml_node callstack = xChunk.child("callstack");
+  if(callstack)
+  {
+    chunk->metadata.flags |= SDChunkFlags::HasCallstack;
+
+    size_t i = 0;
+    for(pugi::xml_node address = callstack.first_child(); address; address = address.next_sibling())
+    {
+      chunk->metadata.callstack.push_back(address.text().as_ullong());
+      i++;
+    }
+  }
+
+  if(xChunk.attribute("opaque"))
+  {
+    pugi::xml_node opaque = xChunk.child("buffer");
+
+    chunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
+
+    chunk->data.children.push_back(new SDObject("Opaque chunk"_lit, "Byte Buffer"_lit));
+    chunk->data.children[0]->type.basetype = SDBasic::Buffer;
+    chunk->data.children[0]->type.byteSize = opaque.attribute("byteLength").as_ullong();
+    chunk->data.children[0]->data.basic.u = opaque.text().as_ullong();
+  }
+  else
+  {
+    for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
+      chunk->data.children.push_back(XML2Obj(child));
+  }
+
+  return chunk;
+}
+
+// finds the end of the element whose opening tag starts at elemStart and parses it into doc on its
+// own, then consumes it. Used for every element small enough to be a document by itself.
+static bool ReadElement(xml_stream_reader &xml, size_t elemStart, const char *name,
+                        pugi::xml_document &doc)
+{
+  size_t tagEnd = xml.Find(">", elemStart);
+
+  if(tagEnd == std::string::npos)
+    return false;
+
+  size_t elemEnd = tagEnd + 1;
+
+  // none of the elements we read this way can nest, so the first closing tag is always the end
+  if(xml.window[tagEnd - 1] != '/')
+  {
+    std::string closeTag = StringFormat::Fmt("</%s>", name);
+
+    elemEnd = xml.Find(closeTag.c_str(), tagEnd);
+
+    if(elemEnd == std::string::npos)
+      return false;
+
+    elemEnd += closeTag.size();
+  }
+
+  doc.load_buffer(xml.window.data() + elemStart, elemEnd - elemStart);
+
+  xml.Consume(elemEnd);
+
+  return true;
+}
+
+// returns true if the text at offs in the window is the opening tag of the named element
+static bool IsElement(xml_stream_reader &xml, size_t offs, const char *name)
+{
+  size_t len = strlen(name);
+
+  // make sure the character after the name is available
+  if(xml.Find(">", offs) == std::string::npos)
+    return false;
+
+  const char *tag = xml.window.c_str() + offs;
+
+  return tag[0] == '<' && !strncmp(tag + 1, name, len) &&
+         (tag[len + 1] == ' ' || tag[len + 1] == '>' || tag[len + 1] == '/');
+}
+
+// decode ASCII section text that was escaped for XML, the equivalent of pugixml's escape and EOL
+// handling. Returns how much of the text was consumed, which stops before any entity or carriage
+// return that might continue in text not yet read.
+static size_t UnescapeSectionText(const char *str, const char *end, bool final, std::string &out)
+{
+  static const struct
+  {
+    const char *entity;
+    char c;
+  } entities[] = {
+      {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''},
+  };
+
+  const char *begin = str;
+
+  while(str < end)
+  {
+    if(str[0] == '&')
+    {
+      const char *semi = (const char *)memchr(str, ';', end - str);
+
+      if(semi == NULL && !final)
+        break;
+
+      bool matched = false;
+      for(size_t i = 0; semi && i < ARRAY_COUNT(entities); i++)
+      {
+        size_t len = strlen(entities[i].entity);
+        if(size_t(semi + 1 - str) == len && !strncmp(str, entities[i].entity, len))
+        {
+          out.push_back(entities[i].c);
+          str += len;
+          matched = true;
+          break;
+        }
+      }
+
+      if(!matched)
+        out.push_back(*(str++));
+    }
+    else if(str[0] == '\r')
+    {
+      if(str + 1 == end && !final)
+        break;
+
+      out.push_back('\n');
+      str++;
+
+      if(str < end && str[0] == '\n')
+        str++;
+    }
+    else
+    {
+      out.push_back(*(str++));
+    }
+  }
+
+  return str - begin;
+}
+
+// streams the contents of a section's data element into the section writer a piece at a time,
+// starting at the window position just after the opening <data> tag.
+static bool ReadSectionData(xml_stream_reader &xml, bool ascii, StreamWriter *writer)
+{
+  std::vector<byte> decoded;
+  std::string text;
+
+  for(;;)
+  {
+    size_t end = xml.window.find("</data>", xml.pos);
+    bool final = end != std::string::npos;
+
+    // when there's more to come, hold back anything that could be the start of the closing tag
+    if(!final)
+    {
+      end = xml.window.find('<', xml.pos);
+      if(end == std::string::npos)
+        end = xml.window.size();
+    }
+
+    const char *str = xml.window.c_str() + xml.pos;
+    size_t used = 0;
+
+    if(ascii)
+    {
+      text.clear();
+      used = UnescapeSectionText(str, xml.window.c_str() + end, final, text);
+      writer->Write(text.data(), text.size());
+    }
+    else
+    {
+      // hex is decoded a line at a time, so only pass complete lines unless this is the last piece
+      used = end - xml.pos;
+      if(!final)
+      {
+        size_t lastLine = xml.window.rfind('\n', end == 0 ? 0 : end - 1);
+        used = lastLine == std::string::npos || lastLine < xml.pos ? 0 : lastLine + 1 - xml.pos;
+      }
+
+      decoded.clear();
+      HexDecode(str, str + used, decoded);
+      writer->Write(decoded.data(), decoded.size());
+    }
+
+    if(final)
+    {
+      xml.Consume(end + 7);
+      return true;
+    }
+
+    xml.Consume(xml.pos + used);
+
+    if(!xml.Fill())
+      return false;
+  }
+}
+
+// the whole document is never held in memory. The header and each section's properties, extended
+// thumbnail and chunk are small, so each is parsed as a document on its own as it's read from the
+// stream, and section data is decoded and written out a piece at a time. Only the structured data
+// being returned grows with the size of the capture.
+static ReplayStatus XML2Structured(xml_stream_reader &xml, const ThumbTypeAndData &thumb,
                                    const ThumbTypeAndData &extThumb,
                                    const StructuredBufferList &buffers, RDCFile *rdc,
                                    uint64_t &version, StructuredChunkList &chunks,
                                    RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
-  doc.load_string(xml);
-
-  pugi::xml_node root = doc.child("rdc");
+  size_t rootStart = xml.Find("<rdc", xml.pos);
 
-  if(!root)
+  if(rootStart == std::string::npos || !IsElement(xml, rootStart, "rdc"))
   {
     RDCERR("Malformed document, expected rdc node");
     return ReplayStatus::FileCorrupted;
   }
 
-  pugi::xml_node xHeader = root.first_child();
+  xml.Consume(xml.Find(">", rootStart) + 1);
 
-  if(strcmp(xHeader.name(), "header"))
+  pugi::xml_document doc;
+
+  size_t elemStart = xml.Find("<", xml.pos);
+
+  if(elemStart == std::string::npos || !IsElement(xml, elemStart, "header") ||
+     !ReadElement(xml, elemStart, "header", doc))
   {
     RDCERR("Malformed document, expected header node");
     return ReplayStatus::FileCorrupted;
   }
 
+  pugi::xml_node xHeader = doc.child("header");
+
   // process the header and push meta-data into RDC
   {
     pugi::xml_node xDriver = xHeader.first_child();
@@ -613,20 +962,34 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
     progress(StructuredProgress(0.1f));
 
   // push in other sections
-  pugi::xml_node xSection = xHeader.next_sibling();
-
-  while(!strcmp(xSection.name(), "section") || !strcmp(xSection.name(), "extended_thumbnail"))
+  for(;;)
   {
-    if(!strcmp(xSection.name(), "extended_thumbnail"))
+    elemStart = xml.Find("<", xml.pos);
+
+    if(elemStart == std::string::npos)
+    {
+      RDCERR("Malformed document, expected chunks node");
+      return ReplayStatus::FileCorrupted;
+    }
+
+    if(IsElement(xml, elemStart, "extended_thumbnail"))
     {
+      if(!ReadElement(xml, elemStart, "extended_thumbnail", doc))
+      {
+        RDCERR("Malformed document, unterminated extended_thumbnail node");
+        return ReplayStatus::FileCorrupted;
+      }
+
+      pugi::xml_node xExtThumbnail = doc.child("extended_thumbnail");
+
       SectionProperties props = {};
       props.type = SectionType::ExtendedThumbnail;
       props.version = 1;
       StreamWriter *w = rdc->WriteSection(props);
 
       ExtThumbnailHeader header;
-      header.width = (uint16_t)xSection.attribute("width").as_uint();
-      header.height = (uint16_t)xSection.attribute("height").as_uint();
+      header.width = (uint16_t)xExtThumbnail.attribute("width").as_uint();
+      header.height = (uint16_t)xExtThumbnail.attribute("height").as_uint();
       header.len = (uint32_t)extThumb.data.size();
       header.format = extThumb.format;
       w->Write(header);
@@ -636,10 +999,37 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
 
       delete w;
 
-      xSection = xSection.next_sibling();
       continue;
     }
 
+    if(!IsElement(xml, elemStart, "section"))
+      break;
+
+    // the section's properties come before its data, so parse everything up to the data as a
+    // document with the section closed off
+    size_t dataStart = xml.Find("<data>", elemStart);
+    size_t sectionEnd = xml.window.find("</section>", elemStart);
+
+    if(dataStart == std::string::npos || (sectionEnd != std::string::npos && sectionEnd < dataStart))
+    {
+      RDCERR("Malformed section, expected data node");
+
+      if(sectionEnd == std::string::npos)
+        return ReplayStatus::FileCorrupted;
+
+      xml.Consume(sectionEnd + 10);
+      continue;
+    }
+
+    {
+      std::string props = xml.window.substr(elemStart, dataStart - elemStart) + "</section>";
+      doc.load_buffer(props.data(), props.size());
+    }
+
+    xml.Consume(dataStart + 6);
+
+    pugi::xml_node xSection = doc.child("section");
+
     SectionProperties props;
 
     if(xSection.attribute("ascii"))
@@ -650,73 +1040,78 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
       props.flags |= SectionFlags::ZstdCompressed;
 
     pugi::xml_node name = xSection.child("name");
+    pugi::xml_node secVer = xSection.child("version");
+    pugi::xml_node type = xSection.child("type");
+
+    StreamWriter *writer = NULL;
+
     if(!name)
-    {
       RDCERR("Malformed section, expected name node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.name = name.text().as_string();
-
-    pugi::xml_node secVer = xSection.child("version");
-    if(!secVer)
-    {
+    else if(!secVer)
       RDCERR("Malformed section, expected version node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.version = secVer.text().as_ullong();
-
-    pugi::xml_node type = xSection.child("type");
-    if(!type)
-    {
+    else if(!type)
       RDCERR("Malformed section, expected type node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.type = (SectionType)type.text().as_uint();
 
-    pugi::xml_node data = xSection.child("data");
-    if(!data)
+    if(name && secVer && type)
     {
-      RDCERR("Malformed section, expected data node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-
-    const char *str = (const char *)data.text().get();
-    size_t len = strlen(str);
-
-    StreamWriter *writer = rdc->WriteSection(props);
+      props.name = name.text().as_string();
+      props.version = secVer.text().as_ullong();
+      props.type = (SectionType)type.text().as_uint();
 
-    if(props.flags & SectionFlags::ASCIIStored)
-    {
-      writer->Write(str, len);
+      writer = rdc->WriteSection(props);
     }
     else
     {
-      std::vector<byte> decoded;
-      HexDecode(str, str + len, decoded);
-      writer->Write(decoded.data(), decoded.size());
+      // still read through the data to skip the section, but discard it
+      writer = new StreamWriter(StreamWriter::InvalidStream);
     }
 
+    bool success = ReadSectionData(xml, bool(props.flags & SectionFlags::ASCIIStored), writer);
+
     writer->Finish();
     delete writer;
 
-    xSection = xSection.next_sibling();
+    sectionEnd = success ? xml.Find("</section>", xml.pos) : std::string::npos;
+
+    if(sectionEnd == std::string::npos)
+    {
+      RDCERR("Malformed document, unterminated section");
+      return ReplayStatus::FileCorrupted;
+    }
+
+    xml.Consume(sectionEnd + 10);
   }
 
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xSection;
-
-  if(strcmp(xSection.name(), "chunks"))
+  if(!IsElement(xml, elemStart, "chunks"))
   {
-    RDCERR("Malformed document, expected chunks node");
+    size_t nameEnd = xml.window.find_first_of(" />", elemStart + 1);
+    RDCERR("Malformed document, unexpected %s node",
+           xml.window.substr(elemStart + 1, nameEnd - elemStart - 1).c_str());
     return ReplayStatus::FileCorrupted;
   }
 
+  xml.Consume(elemStart);
+
+  // parse just the opening tag of the chunks to get the version
+  size_t tagEnd = xml.Find(">", xml.pos);
+
+  bool noChunks = xml.window[tagEnd - 1] == '/';
+
+  {
+    std::string tag = xml.window.substr(xml.pos, tagEnd + 1 - xml.pos);
+    if(!noChunks)
+      tag += "</chunks>";
+
+    doc.load_buffer(tag.data(), tag.size());
+  }
+
+  xml.Consume(tagEnd + 1);
+
+  pugi::xml_node xChunks = doc.child("chunks");
+
   if(!xChunks.attribute("version"))
   {
     RDCERR("Malformed document, expected version attribute");
@@ -725,61 +1120,33 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
 
   version = xChunks.attribute("version").as_ullong();
 
-  size_t chunkIdx = 0;
-  size_t numChunks = std::distance(xChunks.begin(), xChunks.end());
-
-  for(pugi::xml_node xChunk = xChunks.first_child(); xChunk; xChunk = xChunk.next_sibling())
+  while(!noChunks)
   {
-    if(strcmp(xChunk.name(), "chunk"))
-      return ReplayStatus::FileCorrupted;
-
-    SDChunk *chunk = new SDChunk(xChunk.attribute("name").as_string());
+    elemStart = xml.Find("<", xml.pos);
 
-    chunk->metadata.chunkID = xChunk.attribute("id").as_uint();
-    chunk->metadata.length = xChunk.attribute("length").as_uint();
-    if(xChunk.attribute("threadID"))
-      chunk->metadata.threadID = xChunk.attribute("threadID").as_ullong();
-    if(xChunk.attribute("timestamp"))
-      chunk->metadata.timestampMicro = xChunk.attribute("timestamp").as_ullong();
-    if(xChunk.attribute("duration"))
-      chunk->metadata.durationMicro = xChunk.attribute("duration").as_ullong();
-
-    pugi::xml_node callstack = xChunk.child("callstack");
-    if(callstack)
+    if(elemStart == std::string::npos)
     {
-      chunk->metadata.flags |= SDChunkFlags::HasCallstack;
-
-      size_t i = 0;
-      for(pugi::xml_node address = callstack.first_child(); address; address = address.next_sibling())
-      {
-        chunk->metadata.callstack.push_back(address.text().as_ullong());
-        i++;
-      }
+      RDCERR("Malformed document, unterminated chunks node");
+      return ReplayStatus::FileCorrupted;
     }
 
-    if(xChunk.attribute("opaque"))
-    {
-      pugi::xml_node opaque = xChunk.child("buffer");
+    if(!strncmp(xml.window.c_str() + elemStart, "</chunks", 8))
+      break;
 
-      chunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
+    if(!IsElement(xml, elemStart, "chunk"))
+      return ReplayStatus::FileCorrupted;
 
-      chunk->data.children.push_back(new SDObject("Opaque chunk"_lit, "Byte Buffer"_lit));
-      chunk->data.children[0]->type.basetype = SDBasic::Buffer;
-      chunk->data.children[0]->type.byteSize = opaque.attribute("byteLength").as_ullong();
-      chunk->data.children[0]->data.basic.u = opaque.text().as_ullong();
-    }
-    else
+    if(!ReadElement(xml, elemStart, "chunk", doc))
     {
-      for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
-        chunk->data.children.push_back(XML2Obj(child));
+      RDCERR("Malformed document, unterminated chunk");
+      return ReplayStatus::FileCorrupted;
     }
 
-    chunks.push_back(chunk);
+    pugi::xml_node xChunk = doc.first_child();
+    chunks.push_back(XML2Chunk(xChunk));
 
     if(progress)
-      progress(StructuredProgress(0.2f + 0.8f * (float(chunkIdx) / float(numChunks))));
-
-    chunkIdx++;
+      progress(StructuredProgress(0.2f + 0.8f * xml.Progress()));
   }
 
   return ReplayStatus::Succeeded;
@@ -955,12 +1322,9 @@ ReplayStatus importXMLZ(const char *filename, StreamReader &reader, RDCFile *rdc
     }
   }
 
-  uint64_t len = reader.GetSize();
-  char *buf = new char[(size_t)len + 1];
-  reader.Read(buf, (size_t)len);
-  buf[len] = 0;
+  xml_stream_reader xml(reader);
 
-  return XML2Structured(buf, thumb, extThumb, structData.buffers, rdc, structData.version,
+  return XML2Structured(xml, thumb, extThumb, structData.buffers, rdc, structData.version,
                         structData.chunks, progress);
 }
 
@@ -997,4 +1361,181 @@ static ConversionRegistration XMLOnlyConversionRegistration(
         R"(Stores the structured data in an xml tree, with large buffer data omitted - that makes it
 easier to work with but it cannot then be imported.)",
         false,
-    });
\ No newline at end of file
+    });
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+static size_t pugiCurAlloc = 0, pugiPeakAlloc = 0;
+
+static void *CountingAlloc(size_t size)
+{
+  // keep the returned pointer 16-byte aligned
+  size_t *mem = (size_t *)malloc(size + sizeof(size_t) * 2);
+  mem[0] = size;
+  pugiCurAlloc += size;
+  pugiPeakAlloc = RDCMAX(pugiPeakAlloc, pugiCurAlloc);
+  return mem + 2;
+}
+
+static void CountingFree(void *ptr)
+{
+  if(ptr == NULL)
+    return;
+
+  size_t *mem = (size_t *)ptr - 2;
+  pugiCurAlloc -= mem[0];
+  free(mem);
+}
+
+TEST_CASE("Export and import XML with bounded memory", "[xml]")
+{
+  const uint32_t numChunks = 20000;
+
+  SDFile structData;
+  structData.version = 0x10;
+
+  for(uint32_t c = 0; c < numChunks; c++)
+  {
+    SDChunk *chunk = new SDChunk("vkCmdDraw");
+    chunk->metadata.chunkID = 1000 + (c % 50);
+    chunk->metadata.threadID = 1234;
+    chunk->metadata.timestampMicro = c * 10;
+    chunk->metadata.durationMicro = 5;
+
+    SDObject *params = makeSDStruct("params", "DrawParams");
+    params->data.children.push_back(makeSDUInt32("vertexCount", c));
+    params->data.children.push_back(makeSDUInt32("instanceCount", 1));
+    params->data.children.push_back(makeSDInt32("vertexOffset", -int32_t(c)));
+    params->data.children.push_back(makeSDFloat("depth", 0.5f));
+    chunk->data.children.push_back(params);
+    chunk->data.children.push_back(makeSDString("label", "<draw & friends>"));
+
+    structData.chunks.push_back(chunk);
+  }
+
+  RDCFile rdc;
+  rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0, NULL);
+
+  // a binary section spanning many encode pieces, ending in a partial hex line
+  std::vector<byte> sectionData(StreamPieceSize * 8 + 17);
+  for(size_t i = 0; i < sectionData.size(); i++)
+    sectionData[i] = byte(i * 7);
+
+  // an ASCII section with characters that need escaping, including at piece boundaries
+  std::string asciiData;
+  while(asciiData.size() < StreamPieceSize * 3)
+    asciiData += "notes <&> \"quoted\" line\n";
+
+  {
+    SectionProperties props = {};
+    props.type = SectionType::AMDRGPProfile;
+    props.name = ToStr(props.type);
+    props.version = 1;
+
+    StreamWriter *w = rdc.WriteSection(props);
+    w->Write(sectionData.data(), sectionData.size());
+    w->Finish();
+    delete w;
+
+    props.type = SectionType::ResolveDatabase;
+    props.name = ToStr(props.type);
+    props.flags = SectionFlags::ASCIIStored;
+
+    w = rdc.WriteSection(props);
+    w->Write(asciiData.data(), asciiData.size());
+    w->Finish();
+    delete w;
+  }
+
+  std::string filename = FileIO::GetTempFolderFilename() + "/renderdoc_xml_codec_test.xml";
+
+  pugi::allocation_function prevAlloc = pugi::get_memory_allocation_function();
+  pugi::deallocation_function prevFree = pugi::get_memory_deallocation_function();
+  pugi::set_memory_management_functions(&CountingAlloc, &CountingFree);
+
+  pugiCurAlloc = pugiPeakAlloc = 0;
+
+  ReplayStatus status =
+      Structured2XML(filename.c_str(), rdc, structData.version, structData.chunks, NULL);
+
+  size_t exportPeak = pugiPeakAlloc;
+
+  pugiCurAlloc = pugiPeakAlloc = 0;
+
+  RDCFile imported;
+  SDFile importedData;
+  uint64_t xmlSize = 0;
+  size_t importWindow = 0;
+
+  if(status == ReplayStatus::Succeeded)
+  {
+    StreamReader reader(FileIO::fopen(filename.c_str(), "rb"));
+    xmlSize = reader.GetSize();
+
+    xml_stream_reader xml(reader);
+
+    status = XML2Structured(xml, {}, {}, importedData.buffers, &imported, importedData.version,
+                            importedData.chunks, NULL);
+
+    importWindow = xml.peakWindow;
+  }
+
+  size_t importPeak = pugiPeakAlloc;
+
+  pugi::set_memory_management_functions(prevAlloc, prevFree);
+
+  FileIO::Delete(filename.c_str());
+
+  REQUIRE(status == ReplayStatus::Succeeded);
+
+  // a DOM of the whole document would need several times the size of the text
+  CHECK(xmlSize > 8 * 1024 * 1024);
+  CHECK(exportPeak < 256 * 1024);
+  CHECK(importPeak < 256 * 1024);
+  // the sections alone are a couple of MB of text, but only a few pieces are held at once
+  CHECK(importWindow <= StreamPieceSize * 4);
+
+  CHECK(importedData.version == structData.version);
+  REQUIRE(importedData.chunks.size() == structData.chunks.size());
+
+  for(uint32_t c = 0; c < numChunks; c += 997)
+  {
+    const SDChunk *a = structData.chunks[c];
+    const SDChunk *b = importedData.chunks[c];
+
+    CHECK(b->name == a->name);
+    CHECK(b->metadata.chunkID == a->metadata.chunkID);
+    CHECK(b->metadata.timestampMicro == a->metadata.timestampMicro);
+    REQUIRE(b->data.children.size() == 2);
+    CHECK(b->data.children[0]->data.children[0]->data.basic.u == c);
+    CHECK(b->data.children[0]->data.children[2]->data.basic.i == -int64_t(c));
+    CHECK(b->data.children[1]->data.str == "<draw & friends>");
+  }
+
+  REQUIRE(imported.NumSections() == 2);
+  CHECK(imported.GetSectionProperties(0).type == SectionType::AMDRGPProfile);
+  CHECK(imported.GetSectionProperties(1).type == SectionType::ResolveDatabase);
+
+  StreamReader *reader = imported.ReadSection(0);
+
+  std::vector<byte> importedSection;
+  importedSection.resize((size_t)reader->GetSize());
+  reader->Read(importedSection.data(), importedSection.size());
+
+  delete reader;
+
+  CHECK(importedSection == sectionData);
+
+  reader = imported.ReadSection(1);
+
+  std::string importedAscii;
+  importedAscii.resize((size_t)reader->GetSize());
+  reader->Read(&importedAscii[0], importedAscii.size());
+
+  delete reader;
+
+  CHECK(importedAscii == asciiData);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
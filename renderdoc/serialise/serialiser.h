@@ -27,8 +27,10 @@
 #include <list>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include "api/replay/renderdoc_replay.h"
+#include "core/capture_cost.h"
 #include "streamio.h"
 
 // function to deallocate anything from a serialise. Default impl
@@ -42,6 +44,23 @@ void Deserialise(const T &el)
   template <>                          \
   void Deserialise(const type &el);
 
+// types whose serialised form is identical to their layout in memory - plain data with no padding,
+// and a DoSerialise that serialises every member in order with no special handling - can be
+// declared with DECLARE_BULK_SERIALISABLE alongside DECLARE_REFLECTION_STRUCT. Arrays of them are
+// then read and written with a single copy whenever structured data isn't being exported.
+template <class T>
+struct IsBulkSerialisable
+{
+  static const bool value = false;
+};
+
+#define DECLARE_BULK_SERIALISABLE(type) \
+  template <>                           \
+  struct IsBulkSerialisable<type>       \
+  {                                     \
+    static const bool value = true;     \
+  }
+
 // this is a bit of a hack, but necessary. We don't want to have all of our DoSerialise functions
 // defined in global cross-project headers and compiled everywhere, we just want to define them in
 // .cpp files.
@@ -168,6 +187,8 @@ public:
     return StringFormat::Fmt("<No Chunk Lookup: %u>", m_ChunkMetadata.chunkID);
   }
   ChunkLookup GetChunkLookup() { return m_ChunkLookup; }
+  // only names chunks for diagnostics such as capture cost accounting, without enabling export
+  void SetChunkLookup(ChunkLookup lookup) { m_ChunkLookup = lookup; }
   /////////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
@@ -608,6 +629,10 @@ public:
 
       m_StructureStack.pop_back();
     }
+    else if(IsBulkSerialisable<T>::value && count == N)
+    {
+      SerialiseBulk(el, N);
+    }
     else
     {
       for(size_t i = 0; i < N && i < count; i++)
@@ -735,8 +760,16 @@ public:
       }
 #endif
 
-      for(size_t i = 0; el && i < arrayCount; i++)
-        SerialiseDispatch<Serialiser, T>::Do(*this, el[i]);
+      if(IsBulkSerialisable<T>::value)
+      {
+        if(el)
+          SerialiseBulk(el, arrayCount);
+      }
+      else
+      {
+        for(size_t i = 0; el && i < arrayCount; i++)
+          SerialiseDispatch<Serialiser, T>::Do(*this, el[i]);
+      }
     }
 
     return *this;
@@ -806,8 +839,7 @@ public:
       if(IsReading())
         el.resize((size_t)size);
 
-      for(size_t i = 0; i < (size_t)size; i++)
-        SerialiseDispatch<Serialiser, U>::Do(*this, el[i]);
+      SerialiseElements<U>(el, size, std::integral_constant<bool, IsBulkSerialisable<U>::value>());
     }
 
     return *this;
@@ -949,8 +981,7 @@ public:
       if(IsReading())
         el.resize((int)size);
 
-      for(size_t i = 0; i < (size_t)size; i++)
-        SerialiseDispatch<Serialiser, U>::Do(*this, el[i]);
+      SerialiseElements<U>(el, size, std::integral_constant<bool, IsBulkSerialisable<U>::value>());
     }
 
     return *this;
@@ -1500,6 +1531,35 @@ private:
     }
   };
 
+  // reads or writes a whole array of a type declared with DECLARE_BULK_SERIALISABLE at once
+  template <class T>
+  void SerialiseBulk(T *el, uint64_t count)
+  {
+    RDCCOMPILE_ASSERT(!IsBulkSerialisable<T>::value || std::is_trivially_copyable<T>::value,
+                      "Bulk serialisable types must be trivially copyable");
+
+    if(IsWriting())
+      m_Write->Write(el, count * sizeof(T));
+    else if(IsReading())
+      m_Read->Read(el, count * sizeof(T));
+  }
+
+  // the elements of a std::vector or rdcarray, either all at once or one at a time. This is
+  // dispatched on the type so that containers without contiguous storage like std::vector<bool>
+  // still compile.
+  template <class U, class Container>
+  void SerialiseElements(Container &el, uint64_t size, std::true_type)
+  {
+    SerialiseBulk(el.data(), size);
+  }
+
+  template <class U, class Container>
+  void SerialiseElements(Container &el, uint64_t size, std::false_type)
+  {
+    for(size_t i = 0; i < (size_t)size; i++)
+      SerialiseDispatch<Serialiser, U>::Do(*this, el[i]);
+  }
+
   void VerifyArraySize(uint64_t &count)
   {
     uint64_t size = m_Read->GetSize();
@@ -1635,6 +1695,18 @@ BASIC_TYPE_SERIALISE(uint8_t, el, SDBasic::UnsignedInteger, 1);
 BASIC_TYPE_SERIALISE(double, el, SDBasic::Float, 8);
 BASIC_TYPE_SERIALISE(float, el, SDBasic::Float, 4);
 
+// bool and char are left out, since std::vector<bool> and strings have their own handling
+DECLARE_BULK_SERIALISABLE(int64_t);
+DECLARE_BULK_SERIALISABLE(uint64_t);
+DECLARE_BULK_SERIALISABLE(int32_t);
+DECLARE_BULK_SERIALISABLE(uint32_t);
+DECLARE_BULK_SERIALISABLE(int16_t);
+DECLARE_BULK_SERIALISABLE(uint16_t);
+DECLARE_BULK_SERIALISABLE(int8_t);
+DECLARE_BULK_SERIALISABLE(uint8_t);
+DECLARE_BULK_SERIALISABLE(double);
+DECLARE_BULK_SERIALISABLE(float);
+
 BASIC_TYPE_SERIALISE(bool, el, SDBasic::Boolean, 1);
 
 BASIC_TYPE_SERIALISE(char, el, SDBasic::Character, 1);
@@ -1784,6 +1856,7 @@ public:
   ScopedChunk(WriteSerialiser &s, ChunkType i, uint64_t byteLength = 0)
       : m_Idx(uint32_t(i)), m_Ser(s), m_Ended(false)
   {
+    m_Start = CaptureCost::IsEnabled() && m_Ser.GetChunkLookup() ? CaptureCost::Now() : 0;
     m_Ser.WriteChunk(m_Idx, byteLength);
   }
   ~ScopedChunk()
@@ -1794,14 +1867,24 @@ public:
 
   Chunk *Get()
   {
+    // the copy into the chunk is part of the cost, so account for it after instead of in End()
+    uint64_t start = m_Start;
+    m_Start = 0;
+
     End();
-    return new Chunk(m_Ser, m_Idx);
+    Chunk *ret = new Chunk(m_Ser, m_Idx);
+
+    if(start)
+      CaptureCost::Record(m_Idx, m_Ser.GetChunkLookup(), CaptureCost::Now() - start);
+
+    return ret;
   }
 
 private:
   WriteSerialiser &m_Ser;
   uint32_t m_Idx;
   bool m_Ended;
+  uint64_t m_Start;
 
   void End()
   {
@@ -1810,6 +1893,9 @@ private:
     m_Ser.EndChunk();
 
     m_Ended = true;
+
+    if(m_Start)
+      CaptureCost::Record(m_Idx, m_Ser.GetChunkLookup(), CaptureCost::Now() - m_Start);
   }
 };
 #endif
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "serialiser.h"
+#include "common/timing.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
@@ -1528,4 +1529,243 @@ TEST_CASE("Test stringification works as expected", "[tostr]")
   };
 };
 
+// the same layout twice, once declared as bulk serialisable and once not, so the two array paths
+// can be compared
+struct bulkvec
+{
+  float x, y, z;
+  uint32_t w;
+};
+
+struct elementvec
+{
+  float x, y, z;
+  uint32_t w;
+};
+
+// a uint32 wrapped in a struct that isn't bulk serialisable, to compare against plain uint32 arrays
+struct elementword
+{
+  uint32_t v;
+};
+
+DECLARE_REFLECTION_STRUCT(bulkvec);
+DECLARE_BULK_SERIALISABLE(bulkvec);
+DECLARE_REFLECTION_STRUCT(elementvec);
+DECLARE_REFLECTION_STRUCT(elementword);
+
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, bulkvec &el)
+{
+  SERIALISE_MEMBER(x);
+  SERIALISE_MEMBER(y);
+  SERIALISE_MEMBER(z);
+  SERIALISE_MEMBER(w);
+}
+
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, elementvec &el)
+{
+  SERIALISE_MEMBER(x);
+  SERIALISE_MEMBER(y);
+  SERIALISE_MEMBER(z);
+  SERIALISE_MEMBER(w);
+}
+
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, elementword &el)
+{
+  SERIALISE_MEMBER(v);
+}
+
+TEST_CASE("Read/write bulk serialisable arrays", "[serialiser][structured]")
+{
+  rdcarray<uint32_t> words;
+  std::vector<bulkvec> bulk;
+  std::vector<elementvec> element;
+  uint16_t fixed[6] = {2, 3, 5, 7, 11, 13};
+  float *floats = new float[33];
+  uint64_t floatCount = 33;
+
+  for(uint32_t i = 0; i < 1000; i++)
+    words.push_back(i * 2654435761U);
+
+  for(uint32_t i = 0; i < 100; i++)
+  {
+    bulk.push_back({float(i), float(i) * 0.5f, -float(i), i * 7});
+    element.push_back({float(i), float(i) * 0.5f, -float(i), i * 7});
+  }
+
+  for(uint64_t i = 0; i < floatCount; i++)
+    floats[i] = float(i) / 3.0f;
+
+  StreamWriter *bulkBuf = new StreamWriter(StreamWriter::DefaultScratchSize);
+  StreamWriter *elementBuf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    WriteSerialiser ser(bulkBuf, Ownership::Nothing);
+    SCOPED_SERIALISE_CHUNK(5);
+    SERIALISE_ELEMENT(words);
+    SERIALISE_ELEMENT(bulk);
+    SERIALISE_ELEMENT(fixed);
+    SERIALISE_ELEMENT_ARRAY(floats, floatCount);
+  }
+
+  {
+    WriteSerialiser ser(elementBuf, Ownership::Nothing);
+    SCOPED_SERIALISE_CHUNK(5);
+    SERIALISE_ELEMENT(words);
+    SERIALISE_ELEMENT(element);
+    SERIALISE_ELEMENT(fixed);
+    SERIALISE_ELEMENT_ARRAY(floats, floatCount);
+  }
+
+  // both paths produce exactly the same stream
+  REQUIRE(bulkBuf->GetOffset() == elementBuf->GetOffset());
+  CHECK(memcmp(bulkBuf->GetData(), elementBuf->GetData(), (size_t)bulkBuf->GetOffset()) == 0);
+
+  SECTION("Reading back in bulk")
+  {
+    ReadSerialiser ser(new StreamReader(bulkBuf->GetData(), bulkBuf->GetOffset()),
+                       Ownership::Stream);
+
+    rdcarray<uint32_t> readWords;
+    std::vector<bulkvec> readBulk;
+    uint16_t readFixed[6] = {};
+    float *readFloats = NULL;
+    uint64_t readFloatCount = 0;
+
+    CHECK(ser.ReadChunk<uint32_t>() == 5);
+    ser.Serialise("words"_lit, readWords);
+    ser.Serialise("bulk"_lit, readBulk);
+    ser.Serialise("fixed"_lit, readFixed);
+    ser.Serialise("floats"_lit, readFloats, readFloatCount, SerialiserFlags::AllocateMemory);
+    ser.EndChunk();
+
+    REQUIRE_FALSE(ser.IsErrored());
+
+    CHECK((readWords == words));
+    REQUIRE(readBulk.size() == bulk.size());
+    CHECK(memcmp(readBulk.data(), bulk.data(), bulk.size() * sizeof(bulkvec)) == 0);
+    CHECK(memcmp(readFixed, fixed, sizeof(fixed)) == 0);
+    REQUIRE(readFloatCount == floatCount);
+    CHECK(memcmp(readFloats, floats, sizeof(float) * (size_t)floatCount) == 0);
+
+    delete[] readFloats;
+  }
+
+  SECTION("Structured export still sees every element")
+  {
+    ReadSerialiser ser(new StreamReader(bulkBuf->GetData(), bulkBuf->GetOffset()),
+                       Ownership::Stream);
+
+    ser.ConfigureStructuredExport([](uint32_t) -> std::string { return "TestChunk"; }, true);
+
+    rdcarray<uint32_t> readWords;
+    std::vector<bulkvec> readBulk;
+
+    ser.ReadChunk<uint32_t>();
+    ser.Serialise("words"_lit, readWords);
+    ser.Serialise("bulk"_lit, readBulk);
+    ser.EndChunk();
+
+    const SDFile &structData = ser.GetStructuredFile();
+
+    REQUIRE(structData.chunks.size() == 1);
+
+    SDChunk *chunk = structData.chunks[0];
+
+    REQUIRE(chunk->NumChildren() >= 2);
+
+    CHECK(chunk->GetChild(0)->NumChildren() == words.size());
+    CHECK(chunk->GetChild(0)->GetChild(999)->AsUInt32() == words[999]);
+
+    REQUIRE(chunk->GetChild(1)->NumChildren() == bulk.size());
+    CHECK(chunk->GetChild(1)->GetChild(42)->FindChild("w")->AsUInt32() == bulk[42].w);
+    CHECK(chunk->GetChild(1)->GetChild(42)->FindChild("z")->AsFloat() == bulk[42].z);
+  }
+
+  delete[] floats;
+  delete bulkBuf;
+  delete elementBuf;
+};
+
+// average time to write then read back an array, over 10 runs
+template <typename ArrayType>
+static rdcpair<double, double> MeasureArraySerialise(ArrayType &arr)
+{
+  StreamWriter *buf = new StreamWriter(arr.size() * sizeof(arr[0]) + 1024);
+
+  double writeMS = 0.0, readMS = 0.0;
+
+  for(int rep = 0; rep < 10; rep++)
+  {
+    buf->Rewind();
+
+    {
+      PerformanceTimer timer;
+      WriteSerialiser ser(buf, Ownership::Nothing);
+      SCOPED_SERIALISE_CHUNK(5);
+      ser.Serialise("arr"_lit, arr);
+      writeMS += timer.GetMilliseconds();
+    }
+
+    {
+      ArrayType readArr;
+
+      PerformanceTimer timer;
+      ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+      ser.ReadChunk<uint32_t>();
+      ser.Serialise("arr"_lit, readArr);
+      ser.EndChunk();
+      readMS += timer.GetMilliseconds();
+
+      CHECK(readArr.size() == arr.size());
+    }
+  }
+
+  delete buf;
+
+  return {writeMS / 10.0, readMS / 10.0};
+}
+
+TEST_CASE("Benchmark bulk vs per-element array serialisation", "[.][benchmark][serialiser]")
+{
+  const size_t wordCount = 16 * 1024 * 1024;
+  const size_t vecCount = 4 * 1024 * 1024;
+
+  rdcarray<uint32_t> words;
+  rdcarray<elementword> wrapped;
+  words.resize(wordCount);
+  wrapped.resize(wordCount);
+  for(size_t i = 0; i < wordCount; i++)
+  {
+    words[i] = uint32_t(i * 2654435761U);
+    wrapped[i].v = words[i];
+  }
+
+  rdcarray<bulkvec> bulk;
+  rdcarray<elementvec> element;
+  bulk.resize(vecCount);
+  element.resize(vecCount);
+  for(size_t i = 0; i < vecCount; i++)
+  {
+    bulk[i] = {float(i), 1.0f, 2.0f, uint32_t(i)};
+    element[i] = {float(i), 1.0f, 2.0f, uint32_t(i)};
+  }
+
+  rdcpair<double, double> bulkWords = MeasureArraySerialise(words);
+  rdcpair<double, double> elementWords = MeasureArraySerialise(wrapped);
+  rdcpair<double, double> bulkVecs = MeasureArraySerialise(bulk);
+  rdcpair<double, double> elementVecs = MeasureArraySerialise(element);
+
+  WARN("16M uint32 bulk: write " << bulkWords.first << " ms, read " << bulkWords.second << " ms");
+  WARN("16M uint32 per-element: write " << elementWords.first << " ms, read "
+                                        << elementWords.second << " ms");
+  WARN("4M 16-byte structs bulk: write " << bulkVecs.first << " ms, read " << bulkVecs.second
+                                         << " ms");
+  WARN("4M 16-byte structs per-element: write " << elementVecs.first << " ms, read "
+                                                << elementVecs.second << " ms");
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -85,11 +85,11 @@ StreamReader::StreamReader(StreamDummyType)
   m_Dummy = true;
 }
 
-StreamReader::StreamReader(Network::Socket *sock, Ownership own)
+StreamReader::StreamReader(Network::Socket *sock, Ownership own, uint64_t bufferSize)
 {
   m_Sock = sock;
 
-  m_BufferSize = initialBufferSize;
+  m_BufferSize = bufferSize;
   m_BufferBase = AllocAlignedBuffer(m_BufferSize);
   m_BufferHead = m_BufferBase;
 
@@ -311,43 +311,74 @@ bool StreamReader::ReadFromExternal(uint64_t bufferOffs, uint64_t length)
     return false;
   }
 
+  if(!success)
+    HandleError();
+
+  return success;
+}
+
+bool StreamReader::ReadLargeFromSocket(void *data, uint64_t numBytes)
+{
+  // hand over whatever is already buffered
+  uint64_t buffered = Available();
+  memcpy(data, m_BufferHead, (size_t)buffered);
+
+  // the buffer is now entirely consumed, so reset it to empty and account for it in the offset
+  m_ReadOffset += (m_BufferHead - m_BufferBase) + buffered;
+  m_BufferHead = m_BufferBase;
+  m_InputSize = 0;
+
+  uint64_t remaining = numBytes - buffered;
+
+  bool success = m_Sock->Connected() &&
+                 m_Sock->RecvDataBlocking((byte *)data + buffered, (uint32_t)remaining);
+
   if(!success)
   {
-    if(m_File)
-      RDCERR("Error reading from file, errno %d", errno);
-    else if(m_Sock)
-      RDCWARN("Error reading from socket");
+    memset(data, 0, (size_t)numBytes);
+    HandleError();
+    return false;
+  }
 
-    m_HasError = true;
+  m_ReadOffset += remaining;
 
-    // move to error state
-    FreeAlignedBuffer(m_BufferBase);
+  return true;
+}
 
-    if(m_Ownership == Ownership::Stream)
-    {
-      if(m_File)
-        FileIO::fclose(m_File);
+void StreamReader::HandleError()
+{
+  if(m_File)
+    RDCERR("Error reading from file, errno %d", errno);
+  else if(m_Sock)
+    RDCWARN("Error reading from socket");
 
-      if(m_Sock)
-        delete m_Sock;
+  m_HasError = true;
 
-      if(m_Decompressor)
-        delete m_Decompressor;
-    }
+  // move to error state
+  FreeAlignedBuffer(m_BufferBase);
 
-    m_File = NULL;
-    m_Sock = NULL;
-    m_Decompressor = NULL;
-    m_ReadOffset = 0;
-    m_InputSize = 0;
+  if(m_Ownership == Ownership::Stream)
+  {
+    if(m_File)
+      FileIO::fclose(m_File);
 
-    m_BufferSize = 0;
-    m_BufferHead = m_BufferBase = NULL;
+    if(m_Sock)
+      delete m_Sock;
 
-    m_Ownership = Ownership::Nothing;
+    if(m_Decompressor)
+      delete m_Decompressor;
   }
 
-  return success;
+  m_File = NULL;
+  m_Sock = NULL;
+  m_Decompressor = NULL;
+  m_ReadOffset = 0;
+  m_InputSize = 0;
+
+  m_BufferSize = 0;
+  m_BufferHead = m_BufferBase = NULL;
+
+  m_Ownership = Ownership::Nothing;
 }
 
 StreamWriter::StreamWriter(uint64_t initialBufSize)
@@ -368,10 +399,10 @@ StreamWriter::StreamWriter(StreamInvalidType)
   m_HasError = true;
 }
 
-StreamWriter::StreamWriter(Network::Socket *sock, Ownership own)
+StreamWriter::StreamWriter(Network::Socket *sock, Ownership own, uint64_t bufferSize)
 {
-  m_BufferBase = m_BufferHead = AllocAlignedBuffer(initialBufferSize);
-  m_BufferEnd = m_BufferBase + initialBufferSize;
+  m_BufferBase = m_BufferHead = AllocAlignedBuffer(bufferSize);
+  m_BufferEnd = m_BufferBase + bufferSize;
 
   m_Sock = sock;
 
@@ -419,26 +450,19 @@ StreamWriter::~StreamWriter()
 bool StreamWriter::SendSocketData(const void *data, uint64_t numBytes)
 {
   // try to coalesce small writes without doing blocking sends, at least until we're flushed.
-  // if the buffer is already full, flush it.
+  // if it doesn't fit in what's left of the buffer, send what's buffered together with the new
+  // data in one go, without copying it in first.
   if(m_BufferHead + numBytes >= m_BufferEnd)
   {
-    bool success = FlushSocketData();
+    bool success = m_Sock->SendDataBlocking(m_BufferBase, uint32_t(m_BufferHead - m_BufferBase),
+                                            data, (uint32_t)numBytes);
     if(!success)
     {
       HandleError();
       return false;
     }
-  }
 
-  // if it's larger than our buffer (even after flushing) just write directly
-  if(m_BufferHead + numBytes >= m_BufferEnd)
-  {
-    bool success = m_Sock->SendDataBlocking(data, (uint32_t)numBytes);
-    if(!success)
-    {
-      HandleError();
-      return false;
-    }
+    m_BufferHead = m_BufferBase;
   }
   else
   {
@@ -40,6 +40,10 @@ class StreamReader;
 
 typedef std::function<void()> StreamCloseCallback;
 
+// the default size of the buffer that socket streams use to batch up small sends and receives.
+// Anything large enough bypasses the buffer entirely, so growing it only adds copies.
+static const uint64_t DefaultSocketBufferSize = 64 * 1024;
+
 class Compressor
 {
 public:
@@ -83,7 +87,8 @@ public:
   StreamReader(const byte *buffer, uint64_t bufferSize);
   StreamReader(const std::vector<byte> &buffer);
 
-  StreamReader(Network::Socket *sock, Ownership own);
+  StreamReader(Network::Socket *sock, Ownership own,
+               uint64_t bufferSize = DefaultSocketBufferSize);
   StreamReader(FILE *file, uint64_t fileSize, Ownership own);
   StreamReader(FILE *file);
   StreamReader(StreamReader *reader, uint64_t bufferSize);
@@ -158,6 +163,10 @@ public:
       // as well as up to 64 bytes *behind* the head if it exists.
       if(numBytes > Available())
       {
+        // large socket reads go straight into the destination rather than through the buffer
+        if(m_Sock && data && numBytes > m_BufferSize / 2)
+          return ReadLargeFromSocket(data, numBytes);
+
         bool success = Reserve(numBytes);
 
         if(!success)
@@ -212,6 +221,8 @@ private:
   }
   bool Reserve(uint64_t numBytes);
   bool ReadFromExternal(uint64_t bufferOffs, uint64_t length);
+  bool ReadLargeFromSocket(void *data, uint64_t numBytes);
+  void HandleError();
 
   // base of the buffer allocation
   byte *m_BufferBase;
@@ -265,7 +276,8 @@ public:
   StreamWriter(StreamInvalidType);
   StreamWriter(uint64_t initialBufSize);
   StreamWriter(FILE *file, Ownership own);
-  StreamWriter(Network::Socket *file, Ownership own);
+  StreamWriter(Network::Socket *file, Ownership own,
+               uint64_t bufferSize = DefaultSocketBufferSize);
   StreamWriter(Compressor *compressor, Ownership own);
 
   bool IsErrored() { return m_HasError; }
@@ -308,4 +308,98 @@ TEST_CASE("Test stream I/O operations over the network", "[streamio][network]")
   delete server;
 };
 
+TEST_CASE("Benchmark stream I/O throughput over a loopback socket",
+          "[.][benchmark][streamio][network]")
+{
+  uint16_t port = 8255;
+  Network::Socket *server = NULL;
+
+  for(uint16_t probe = 0; probe < 20; probe++)
+  {
+    server = Network::CreateServerSocket("localhost", port, 2);
+
+    if(server)
+      break;
+
+    port++;
+  }
+
+  REQUIRE(server);
+
+  Network::Socket *sender = Network::CreateClientSocket("localhost", port, 10);
+
+  REQUIRE(sender);
+
+  Network::Socket *receiver = server->AcceptClient(250);
+
+  REQUIRE(receiver);
+
+  StreamWriter writer(sender, Ownership::Nothing);
+  StreamReader reader(receiver, Ownership::Nothing);
+
+  // sends totalSize bytes as a series of chunks, each a small header followed by payloadSize bytes
+  // written elementSize at a time, flushed at the end of each chunk like the serialiser does.
+  auto measure = [&writer, &reader](uint64_t totalSize, uint64_t payloadSize,
+                                    uint64_t elementSize) {
+    std::vector<byte> payload;
+    payload.resize((size_t)payloadSize);
+    for(size_t i = 0; i < payload.size(); i++)
+      payload[i] = byte(i * 7);
+
+    const uint64_t numChunks = totalSize / payloadSize;
+
+    bool readOK = true;
+
+    Threading::ThreadHandle recvThread =
+        Threading::CreateThread([&reader, &readOK, numChunks, payloadSize, elementSize]() {
+          std::vector<byte> dest;
+          dest.resize((size_t)payloadSize);
+
+          for(uint64_t c = 0; c < numChunks; c++)
+          {
+            uint64_t header = 0;
+            reader.Read(header);
+            for(uint64_t offs = 0; offs < payloadSize; offs += elementSize)
+              reader.Read(dest.data() + offs, elementSize);
+
+            readOK &= (header == c);
+          }
+
+          readOK &= (dest[1] == byte(7)) && !reader.IsErrored();
+        });
+
+    PerformanceTimer timer;
+
+    for(uint64_t c = 0; c < numChunks; c++)
+    {
+      writer.Write(c);
+      for(uint64_t offs = 0; offs < payloadSize; offs += elementSize)
+        writer.Write(payload.data() + offs, elementSize);
+      writer.Flush();
+    }
+
+    Threading::JoinThread(recvThread);
+    Threading::CloseThread(recvThread);
+
+    double ms = timer.GetMilliseconds();
+
+    CHECK(readOK);
+    CHECK_FALSE(writer.IsErrored());
+
+    return double(numChunks * payloadSize) / (1024.0 * 1024.0) / (ms / 1000.0);
+  };
+
+  double large = measure(512 * 1024 * 1024, 4 * 1024 * 1024, 4 * 1024 * 1024);
+  double medium = measure(256 * 1024 * 1024, 256 * 1024, 256 * 1024);
+  double small = measure(64 * 1024 * 1024, 64 * 1024, 64);
+
+  WARN("Loopback throughput with 4MB payloads: " << large << " MB/s");
+  WARN("Loopback throughput with 256kB payloads: " << medium << " MB/s");
+  WARN("Loopback throughput with 64 byte elements: " << small << " MB/s");
+
+  delete sender;
+  delete receiver;
+  delete server;
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
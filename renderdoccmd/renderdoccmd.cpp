@@ -26,7 +26,12 @@
 #include "renderdoccmd.h"
 #include <app/renderdoc_app.h>
 #include <replay/version.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 
 // normally this is in the renderdoc core library, but it's needed for the 'unknown enum' path,
 // so we implement it here using ostringstream. It's not great, but this is a very uncommon path -
@@ -650,6 +655,33 @@ private:
   std::vector<std::string> names;
 };
 
+// sort the formats by the length of the extension, so we check the longest ones first. This
+// means that .zip.xml will get chosen before just .xml
+static void sort_formats(rdcarray<CaptureFileFormat> &formats)
+{
+  std::sort(formats.begin(), formats.end(),
+            [](const CaptureFileFormat &a, const CaptureFileFormat &b) {
+              return a.extension.size() > b.extension.size();
+            });
+}
+
+// try to guess the format by looking for the extension in the filename. The formats must have
+// been sorted with sort_formats
+static std::string guess_format(const rdcarray<CaptureFileFormat> &formats,
+                                const std::string &filename)
+{
+  for(const CaptureFileFormat &f : formats)
+  {
+    std::string extension = ".";
+    extension += f.extension;
+
+    if(filename.find(extension.c_str()) != std::string::npos)
+      return f.extension;
+  }
+
+  return "";
+}
+
 struct ConvertCommand : public Command
 {
   rdcarray<CaptureFileFormat> m_Formats;
@@ -709,28 +741,10 @@ struct ConvertCommand : public Command
     std::string infmt = parser.get<std::string>("input-format");
     std::string outfmt = parser.get<std::string>("convert-format");
 
-    // sort the formats by the length of the extension, so we check the longest ones first. This
-    // means that .zip.xml will get chosen before just .xml
-    std::sort(m_Formats.begin(), m_Formats.end(),
-              [](const CaptureFileFormat &a, const CaptureFileFormat &b) {
-                return a.extension.size() > b.extension.size();
-              });
+    sort_formats(m_Formats);
 
     if(infmt.empty())
-    {
-      // try to guess the format by looking for the extension in the filename
-      for(CaptureFileFormat f : m_Formats)
-      {
-        std::string extension = ".";
-        extension += f.extension;
-
-        if(infile.find(extension.c_str()) != std::string::npos)
-        {
-          infmt = f.extension;
-          break;
-        }
-      }
-    }
+      infmt = guess_format(m_Formats, infile);
 
     if(infmt.empty())
     {
@@ -740,20 +754,7 @@ struct ConvertCommand : public Command
     }
 
     if(outfmt.empty())
-    {
-      // try to guess the format by looking for the extension in the filename
-      for(CaptureFileFormat f : m_Formats)
-      {
-        std::string extension = ".";
-        extension += f.extension;
-
-        if(outfile.find(extension.c_str()) != std::string::npos)
-        {
-          outfmt = f.extension;
-          break;
-        }
-      }
-    }
+      outfmt = guess_format(m_Formats, outfile);
 
     if(outfmt.empty())
     {
@@ -788,6 +789,395 @@ struct ConvertCommand : public Command
   }
 };
 
+struct BatchCommand : public Command
+{
+  struct Job
+  {
+    int line = 0;
+    std::string op;
+    std::string input;
+    std::string output;
+    std::string arg;
+
+    std::string error;
+    double ms = 0.0;
+  };
+
+  rdcarray<CaptureFileFormat> m_Formats;
+
+  BatchCommand(const GlobalEnvironment &env) : Command(env) {}
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.add<uint32_t>("jobs", 'j',
+                         "How many captures to process at once. Default is 0, which is one per "
+                         "CPU core.",
+                         false, 0);
+    parser.add<std::string>("timings", 't', "Write per-file timings as CSV to this file.", false);
+    parser.set_footer(
+        "<manifest.txt>\n\n"
+        "Each line of the manifest is one operation on one capture, with blank lines and lines\n"
+        "starting with # ignored. Paths containing spaces can be quoted. Operations are:\n\n"
+        "  convert <capture> <output> [format]   Convert, guessing the format from the output\n"
+        "                                        filename if not given.\n"
+        "  thumb <capture> <output> [max-size]   Save the embedded thumbnail, as jpg, png, bmp or\n"
+        "                                        tga depending on the output filename.\n"
+        "  stats <capture> <output>              Write a summary of the capture's sections and\n"
+        "                                        structured data to a text file.");
+  }
+  virtual const char *Description()
+  {
+    return "Process a manifest of captures concurrently, reporting per-file timings.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+
+  static std::vector<std::string> tokenise(const std::string &line)
+  {
+    std::vector<std::string> ret;
+
+    size_t i = 0;
+    while(i < line.size())
+    {
+      while(i < line.size() && isspace((unsigned char)line[i]))
+        i++;
+
+      if(i >= line.size())
+        break;
+
+      std::string token;
+
+      if(line[i] == '"')
+      {
+        size_t end = line.find('"', i + 1);
+        if(end == std::string::npos)
+          end = line.size();
+        token = line.substr(i + 1, end - i - 1);
+        i = end + 1;
+      }
+      else
+      {
+        size_t end = i;
+        while(end < line.size() && !isspace((unsigned char)line[end]))
+          end++;
+        token = line.substr(i, end - i);
+        i = end;
+      }
+
+      ret.push_back(token);
+    }
+
+    return ret;
+  }
+
+  static bool parse_manifest(std::istream &in, std::vector<Job> &jobs)
+  {
+    bool ok = true;
+
+    std::string line;
+    for(int lineNum = 1; std::getline(in, line); lineNum++)
+    {
+      std::vector<std::string> tokens = tokenise(line);
+
+      if(tokens.empty() || tokens[0].empty() || tokens[0][0] == '#')
+        continue;
+
+      Job job;
+      job.line = lineNum;
+      job.op = tokens[0];
+
+      size_t required = 3, allowed = 4;
+      if(job.op == "stats")
+        allowed = 3;
+
+      if(job.op != "convert" && job.op != "thumb" && job.op != "stats")
+      {
+        std::cerr << "Line " << lineNum << ": unknown operation '" << job.op << "'." << std::endl;
+        ok = false;
+        continue;
+      }
+
+      if(tokens.size() < required || tokens.size() > allowed)
+      {
+        std::cerr << "Line " << lineNum << ": wrong number of parameters for '" << job.op << "'."
+                  << std::endl;
+        ok = false;
+        continue;
+      }
+
+      job.input = tokens[1];
+      job.output = tokens[2];
+      if(tokens.size() > 3)
+        job.arg = tokens[3];
+
+      jobs.push_back(job);
+    }
+
+    return ok;
+  }
+
+  void convert(ICaptureFile *file, Job &job)
+  {
+    std::string outfmt = job.arg.empty() ? guess_format(m_Formats, job.output) : job.arg;
+
+    if(outfmt.empty())
+    {
+      job.error = "couldn't guess output format from filename";
+      return;
+    }
+
+    ReplayStatus st = file->Convert(job.output.c_str(), outfmt.c_str(), NULL, NULL);
+
+    if(st != ReplayStatus::Succeeded)
+      job.error = "couldn't convert: " + std::string(ToStr(st));
+  }
+
+  void thumb(ICaptureFile *file, Job &job)
+  {
+    FileType type = FileType::JPG;
+
+    const char *dot = strrchr(job.output.c_str(), '.');
+
+    if(dot != NULL && strstr(dot, "png"))
+      type = FileType::PNG;
+    else if(dot != NULL && strstr(dot, "tga"))
+      type = FileType::TGA;
+    else if(dot != NULL && strstr(dot, "bmp"))
+      type = FileType::BMP;
+
+    uint32_t maxsize = job.arg.empty() ? 0 : (uint32_t)atoi(job.arg.c_str());
+
+    bytebuf buf = file->GetThumbnail(type, maxsize).data;
+
+    if(buf.empty())
+    {
+      job.error = "no thumbnail";
+      return;
+    }
+
+    FILE *f = fopen(job.output.c_str(), "wb");
+
+    if(!f)
+    {
+      job.error = "couldn't open destination file";
+      return;
+    }
+
+    fwrite(buf.data(), 1, buf.size(), f);
+    fclose(f);
+  }
+
+  void stats(ICaptureFile *file, Job &job)
+  {
+    std::ofstream out(job.output.c_str());
+
+    if(!out)
+    {
+      job.error = "couldn't open destination file";
+      return;
+    }
+
+    out << "capture: " << job.input << std::endl;
+    out << "driver: " << (std::string)file->DriverName() << std::endl;
+
+    int numSections = file->GetSectionCount();
+    out << "sections: " << numSections << std::endl;
+    for(int i = 0; i < numSections; i++)
+    {
+      SectionProperties props = file->GetSectionProperties(i);
+      out << "  " << (std::string)props.name << ": " << props.uncompressedSize << " bytes ("
+          << props.compressedSize << " on disk)" << std::endl;
+    }
+
+    const SDFile &sdfile = file->GetStructuredData();
+
+    struct ChunkStats
+    {
+      uint64_t count = 0;
+      uint64_t bytes = 0;
+      int64_t durationMicro = 0;
+    };
+
+    std::map<std::string, ChunkStats> chunkStats;
+    uint64_t totalBytes = 0;
+
+    for(const SDChunk *chunk : sdfile.chunks)
+    {
+      ChunkStats &c = chunkStats[chunk->name];
+      c.count++;
+      c.bytes += chunk->metadata.length;
+      if(chunk->metadata.durationMicro > 0)
+        c.durationMicro += chunk->metadata.durationMicro;
+      totalBytes += chunk->metadata.length;
+    }
+
+    uint64_t bufferBytes = 0;
+    for(const bytebuf *buf : sdfile.buffers)
+      bufferBytes += buf->size();
+
+    out << "chunks: " << sdfile.chunks.size() << " (" << totalBytes << " bytes)" << std::endl;
+    out << "buffers: " << sdfile.buffers.size() << " (" << bufferBytes << " bytes)" << std::endl;
+
+    // most common chunks first
+    std::vector<std::pair<std::string, ChunkStats>> sorted(chunkStats.begin(), chunkStats.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<std::string, ChunkStats> &a,
+                 const std::pair<std::string, ChunkStats> &b) {
+                return a.second.count > b.second.count;
+              });
+
+    for(const std::pair<std::string, ChunkStats> &c : sorted)
+      out << "  " << c.first << ": " << c.second.count << " chunks, " << c.second.bytes
+          << " bytes, " << c.second.durationMicro << " us" << std::endl;
+  }
+
+  void run(Job &job)
+  {
+    auto start = std::chrono::steady_clock::now();
+
+    std::string infmt = guess_format(m_Formats, job.input);
+    if(infmt.empty())
+      infmt = "rdc";
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile();
+
+    ReplayStatus st = file->OpenFile(job.input.c_str(), infmt.c_str(), NULL);
+
+    if(st != ReplayStatus::Succeeded)
+      job.error = "couldn't open as '" + infmt + "': " + std::string(ToStr(st));
+    else if(job.op == "convert")
+      convert(file, job);
+    else if(job.op == "thumb")
+      thumb(file, job);
+    else if(job.op == "stats")
+      stats(file, job);
+
+    file->Shutdown();
+
+    job.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                 .count();
+  }
+
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    std::vector<std::string> rest = parser.rest();
+    if(rest.empty())
+    {
+      std::cerr << "Error: batch command requires a manifest filename." << std::endl
+                << std::endl
+                << parser.usage();
+      return 1;
+    }
+
+    std::string manifest = rest[0];
+
+    rest.erase(rest.begin());
+
+    RENDERDOC_InitGlobalEnv(m_Env, convertArgs(rest));
+
+    std::vector<Job> jobs;
+
+    {
+      std::ifstream in(manifest.c_str());
+
+      if(!in)
+      {
+        std::cerr << "Couldn't open manifest '" << manifest << "'" << std::endl;
+        return 1;
+      }
+
+      if(!parse_manifest(in, jobs))
+        return 1;
+    }
+
+    // everything is processed in this one process, so driver registration and any caches are
+    // shared across all the captures rather than paid for each one.
+    {
+      ICaptureFile *tmp = RENDERDOC_OpenCaptureFile();
+      m_Formats = tmp->GetCaptureFileFormats();
+      tmp->Shutdown();
+    }
+
+    sort_formats(m_Formats);
+
+    uint32_t numWorkers = parser.get<uint32_t>("jobs");
+    if(numWorkers == 0)
+      numWorkers = std::max(1U, std::thread::hardware_concurrency());
+    numWorkers = std::min(numWorkers, (uint32_t)jobs.size());
+
+    std::cout << "Processing " << jobs.size() << " operations with " << numWorkers << " workers."
+              << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::atomic<size_t> next(0);
+    size_t done = 0;
+    std::mutex outputLock;
+
+    std::vector<std::thread> workers;
+    for(uint32_t w = 0; w < numWorkers; w++)
+    {
+      workers.push_back(std::thread([this, &jobs, &next, &done, &outputLock]() {
+        for(size_t i = next++; i < jobs.size() && !killSignal; i = next++)
+        {
+          Job &job = jobs[i];
+
+          run(job);
+
+          std::lock_guard<std::mutex> lock(outputLock);
+
+          done++;
+
+          std::cout << "[" << done << "/" << jobs.size() << "] " << job.op << " '" << job.input
+                    << "' in " << job.ms << " ms";
+          if(job.error.empty())
+            std::cout << std::endl;
+          else
+            std::cout << " FAILED: " << job.error << std::endl;
+        }
+      }));
+    }
+
+    for(std::thread &t : workers)
+      t.join();
+
+    double totalMS =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    double serialMS = 0.0;
+    for(const Job &job : jobs)
+    {
+      if(!job.error.empty())
+        failed++;
+      serialMS += job.ms;
+    }
+
+    std::cout << "Finished " << jobs.size() << " operations in " << totalMS << " ms ("
+              << serialMS << " ms of processing), " << failed << " failed." << std::endl;
+
+    std::string timings = parser.get<std::string>("timings");
+
+    if(!timings.empty())
+    {
+      std::ofstream csv(timings.c_str());
+
+      if(!csv)
+      {
+        std::cerr << "Couldn't open timings file '" << timings << "'" << std::endl;
+      }
+      else
+      {
+        csv << "line,operation,input,output,ms,error" << std::endl;
+        for(const Job &job : jobs)
+          csv << job.line << "," << job.op << ",\"" << job.input << "\",\"" << job.output << "\","
+              << job.ms << ",\"" << job.error << "\"" << std::endl;
+      }
+    }
+
+    return failed > 0 ? 1 : 0;
+  }
+};
+
 struct TestCommand : public Command
 {
   TestCommand(const GlobalEnvironment &env) : Command(env) {}
@@ -1199,6 +1589,7 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
     add_command("capaltbit", new CapAltBitCommand(env));
     add_command("test", new TestCommand(env));
     add_command("convert", new ConvertCommand(env));
+    add_command("batch", new BatchCommand(env));
     add_command("embed", new EmbeddedSectionCommand(env, false));
     add_command("extract", new EmbeddedSectionCommand(env, true));
 